@@ -0,0 +1,370 @@
+/*
+ * batchsolver.cpp
+ * See batchsolver.h for more information
+ */
+
+#include "batchsolver.h"
+#include "maskkernels.h"
+#include <QtAlgorithms>
+
+static const quint16 ALL_NOTES = 0x3FE;
+
+static inline bool isSingle(quint16 m) {
+    return m && !(m & (m - 1));
+}
+
+BatchSolver::BatchSolver() {
+    numCells = numRuns = lanes = 0;
+    type = 0;
+    downRun = rightRun = 0;
+    runFirst = runStride = runLength = 0;
+    mask = 0;
+    fixed = 0;
+    runClue = 0;
+    runCombos = 0;
+    status = 0;
+    allowed = necessary = 0;
+    runDirty = 0;
+}
+
+void BatchSolver::load(const BoardModel &model, int lanes) {
+    this->lanes = lanes;
+    numCells = model.getNumCells();
+    numRuns = model.getNumRuns();
+
+    arena.reserve(numCells*int(sizeof(quint8)) +
+                  2*numCells*int(sizeof(int)) +
+                  3*numRuns*int(sizeof(int)) +
+                  numCells*lanes*int(sizeof(quint16)) +
+                  numCells*lanes*int(sizeof(quint8)) +
+                  numRuns*lanes*int(sizeof(qint16)) +
+                  numRuns*lanes*int(sizeof(quint16)) +
+                  lanes*int(sizeof(quint8)) +
+                  2*lanes*int(sizeof(quint16)) +
+                  numRuns*int(sizeof(quint8)) +
+                  14*SolverArena::ALIGNMENT);
+    type = arena.alloc<quint8>(numCells);
+    downRun = arena.alloc<int>(numCells);
+    rightRun = arena.alloc<int>(numCells);
+    runFirst = arena.alloc<int>(numRuns);
+    runStride = arena.alloc<int>(numRuns);
+    runLength = arena.alloc<int>(numRuns);
+    mask = arena.alloc<quint16>(numCells*lanes);
+    fixed = arena.alloc<quint8>(numCells*lanes);
+    runClue = arena.alloc<qint16>(numRuns*lanes);
+    runCombos = arena.alloc<quint16>(numRuns*lanes);
+    status = arena.alloc<quint8>(lanes);
+    allowed = arena.alloc<quint16>(lanes);
+    necessary = arena.alloc<quint16>(lanes);
+    runDirty = arena.alloc<quint8>(numRuns);
+
+    //Sizing bug: no lanes, so nothing gets solved
+    if (arena.hasFailed()) {
+        this->lanes = numCells = numRuns = 0;
+        return;
+    }
+
+    for (int i = 0; i < numCells; i++) {
+        type[i] = model.type[i];
+        downRun[i] = model.downRun[i];
+        rightRun[i] = model.rightRun[i];
+    }
+    for (int run = 0; run < numRuns; run++) {
+        runFirst[run] = model.runFirst[run];
+        runStride[run] = model.runStride[run];
+        runLength[run] = model.runLength[run];
+    }
+
+    //Lanes without a board stay empty and broken
+    for (int l = 0; l < lanes; l++) {
+        status[l] = LANE_BROKEN;
+    }
+    for (int i = 0; i < numCells*lanes; i++) {
+        mask[i] = 0;
+        fixed[i] = false;
+    }
+    for (int i = 0; i < numRuns*lanes; i++) {
+        runClue[i] = 0;
+        runCombos[i] = 0;
+    }
+}
+
+void BatchSolver::setLane(int lane, const BoardModel &model) {
+    Q_ASSERT(model.getNumCells() == numCells && model.getNumRuns() == numRuns);
+
+    for (int i = 0; i < numCells; i++) {
+        quint16 &m = mask[i*lanes + lane];
+        quint8 &f = fixed[i*lanes + lane];
+        if (type[i] == CLUE) {
+            m = 0;
+            f = false;
+        }
+        else if (model.fixed[i] && model.value[i]) {
+            m = quint16(1 << model.value[i]);
+            f = true;
+        }
+        else {
+            m = ALL_NOTES;
+            f = false;
+        }
+    }
+
+    for (int run = 0; run < numRuns; run++) {
+        runClue[run*lanes + lane] = qint16(model.runClue[run]);
+        runCombos[run*lanes + lane] = quint16((1 << Solver::getComboCount(model.runClue[run],
+                                                                          runLength[run])) - 1);
+        runDirty[run] = true;
+    }
+
+    status[lane] = LANE_UNSOLVED;
+}
+
+void BatchSolver::store(int lane, BoardModel &model) const {
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == CLUE)
+            continue;
+
+        quint16 m = mask[i*lanes + lane];
+        model.fixed[i] = fixed[i*lanes + lane];
+        model.value[i] = quint8(isSingle(m) ? qCountTrailingZeroBits(m) : 0);
+        //Fixed cells don't have notes
+        model.mask[i] = model.fixed[i] ? 0 : m;
+    }
+}
+
+void BatchSolver::fixCell(int lane, int cell, int v) {
+    mask[cell*lanes + lane] = quint16(1 << v);
+    fixed[cell*lanes + lane] = true;
+    markRunsDirty(cell);
+}
+
+void BatchSolver::markRunsDirty(int cell) {
+    if (downRun[cell] != -1)
+        runDirty[downRun[cell]] = true;
+    if (rightRun[cell] != -1)
+        runDirty[rightRun[cell]] = true;
+}
+
+void BatchSolver::propagate() {
+    const MaskKernels &kernels = MaskKernels::get(lanes);
+
+    while (true) {
+        //Sweep over the dirty runs until none are left
+        bool dirty = true;
+        while (dirty) {
+            dirty = false;
+            for (int run = 0; run < numRuns; run++) {
+                if (!runDirty[run])
+                    continue;
+                runDirty[run] = false;
+
+                int first = runFirst[run], stride = runStride[run];
+                int length = runLength[run];
+
+                //Combos are pruned lane by lane, but the
+                //mask rules run on every lane at once
+                pruneRunCombos(run);
+                bool changed = kernels.filterByCombos(mask, lanes, first, stride, length, allowed);
+                changed |= kernels.adjustByRange(mask, lanes, first, stride, length, runClue + run*lanes);
+                changed |= kernels.forceDigits(mask, lanes, first, stride, length, necessary);
+                if (!changed)
+                    continue;
+
+                dirty = true;
+                for (int k = 0, i = first; k < length; k++, i += stride) {
+                    markRunsDirty(i);
+                }
+            }
+        }
+        updateStatus();
+
+        //The per-lane rules cost more, so they only get the
+        //lanes the kernels left unsolved, and then the kernels
+        //go again on the runs they changed
+        bool changed = false;
+        for (int run = 0; run < numRuns; run++) {
+            if (!filterRunByCells(run) && !removeRunNakedSubsets(run))
+                continue;
+
+            changed = true;
+            int first = runFirst[run], stride = runStride[run];
+            int length = runLength[run];
+            for (int k = 0, i = first; k < length; k++, i += stride) {
+                markRunsDirty(i);
+            }
+        }
+        if (!changed)
+            break;
+    }
+}
+
+void BatchSolver::pruneRunCombos(int run) {
+    int first = runFirst[run], stride = runStride[run];
+    int length = runLength[run];
+
+    for (int l = 0; l < lanes; l++) {
+        int clue = runClue[run*lanes + l];
+
+        quint16 solved = 0;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            quint16 m = mask[i*lanes + l];
+            if (isSingle(m))
+                solved |= m;
+        }
+
+        //Delete the combos that don't include every solved number,
+        //or that don't have any of a cell's notes. Collect the
+        //union and intersection of the rest for the mask rules
+        quint16 &combos = runCombos[run*lanes + l];
+        quint16 comboOr = 0, comboAnd = ALL_NOTES;
+        for (int n = 0; n < 12; n++) {
+            if (!(combos & (1 << n)))
+                continue;
+            quint16 combo = Solver::getComboMask(clue, length, n);
+            bool possible = (combo & solved) == solved;
+            for (int k = 0, i = first; possible && k < length; k++, i += stride) {
+                if (!(mask[i*lanes + l] & combo))
+                    possible = false;
+            }
+            if (!possible) {
+                combos &= ~(1 << n);
+                continue;
+            }
+            comboOr |= combo;
+            comboAnd &= combo;
+        }
+
+        allowed[l] = comboOr;
+        necessary[l] = combos ? comboAnd : 0;
+    }
+}
+
+bool BatchSolver::filterRunByCells(int run) {
+    int first = runFirst[run], stride = runStride[run];
+    int length = runLength[run];
+
+    bool changed = false;
+    for (int l = 0; l < lanes; l++) {
+        if (status[l] != LANE_UNSOLVED)
+            continue;
+
+        //The empty cells have to make up the rest of the
+        //clue, without the numbers of the solved ones
+        quint16 masks[9], cellAllowed[9], solved = 0;
+        int cells[9], sum = runClue[run*lanes + l], num = 0;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            quint16 m = mask[i*lanes + l];
+            if (isSingle(m)) {
+                solved |= m;
+                sum -= qCountTrailingZeroBits(m);
+            }
+            else {
+                cells[num] = i;
+                masks[num++] = m;
+            }
+        }
+        if (!num)
+            continue;
+        for (int n = 0; n < num; n++) {
+            masks[n] &= ~solved;
+            cellAllowed[n] = 0;
+        }
+        if (sum >= 1 && !runMemo.lookup(sum, num, masks, cellAllowed))
+            runMemo.insert(sum, num, masks, cellAllowed);
+
+        for (int n = 0; n < num; n++) {
+            quint16 &m = mask[cells[n]*lanes + l];
+            quint16 filtered = m & cellAllowed[n];
+            changed |= filtered != m;
+            m = filtered;
+        }
+    }
+    return changed;
+}
+
+bool BatchSolver::removeRunNakedSubsets(int run) {
+    int first = runFirst[run], stride = runStride[run];
+    int length = runLength[run];
+
+    bool changed = false;
+    for (int l = 0; l < lanes; l++) {
+        if (status[l] != LANE_UNSOLVED || qPopulationCount(runCombos[run*lanes + l]) != 1)
+            continue;
+
+        //N cells with only the same N notes have those
+        //numbers between them, so the others can't
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            quint16 subset = mask[i*lanes + l];
+            int size = qPopulationCount(subset);
+            if (size < 2)
+                continue;
+
+            int count = 0;
+            for (int k2 = 0, i2 = first; k2 < length; k2++, i2 += stride) {
+                if (mask[i2*lanes + l] == subset)
+                    count++;
+            }
+            //More of them than numbers breaks the board
+            if (count > size) {
+                status[l] = LANE_BROKEN;
+                break;
+            }
+            if (count < size)
+                continue;
+
+            for (int k2 = 0, i2 = first; k2 < length; k2++, i2 += stride) {
+                quint16 &m = mask[i2*lanes + l];
+                if (m == subset || !(m & subset))
+                    continue;
+                m &= quint16(~subset);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+void BatchSolver::updateStatus() {
+    for (int l = 0; l < lanes; l++) {
+        if (status[l] == LANE_BROKEN)
+            continue;
+
+        bool empty = false, allSingle = true;
+        for (int i = 0; i < numCells; i++) {
+            if (type[i] == CLUE)
+                continue;
+            quint16 m = mask[i*lanes + l];
+            if (!m)
+                empty = true;
+            else if (!isSingle(m))
+                allSingle = false;
+        }
+        if (empty) {
+            status[l] = LANE_BROKEN;
+            continue;
+        }
+        if (!allSingle) {
+            status[l] = LANE_UNSOLVED;
+            continue;
+        }
+
+        //Every cell has a value, check the runs
+        status[l] = LANE_SOLVED;
+        for (int run = 0; run < numRuns; run++) {
+            int first = runFirst[run], stride = runStride[run];
+            int length = runLength[run];
+
+            int sum = 0;
+            quint16 used = 0;
+            for (int k = 0, i = first; k < length; k++, i += stride) {
+                quint16 m = mask[i*lanes + l];
+                if (used & m)
+                    status[l] = LANE_BROKEN;
+                used |= m;
+                sum += qCountTrailingZeroBits(m);
+            }
+            if (sum != runClue[run*lanes + l])
+                status[l] = LANE_BROKEN;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * batchsolver.h
+ *
+ * The BatchSolver solves many boards with the same topology
+ * (cell types and runs) in lockstep, using only logic. The
+ * generator uses it to try several clue assignments for one
+ * layout at once.
+ *
+ * Each board is a lane. The topology is stored once, and the
+ * per-lane state (masks, fixed flags, clues and run combos) is
+ * interleaved by lane, so every rule is applied to one run of
+ * every board at once with the MaskKernels. The rest of the
+ * Solver's rules (which notes each cell can keep, through a
+ * RunMemo, and naked subsets) cost more, and are applied a lane
+ * at a time once the kernels have nothing left to do. Solved
+ * cells are masks with a single bit.
+ */
+
+#ifndef BATCHSOLVER_H
+#define BATCHSOLVER_H
+
+#include "boardmodel.h"
+#include "solver.h"
+#include "runmemo.h"
+#include "common.h"
+
+class BatchSolver {
+public:
+    enum LaneStatus { LANE_UNSOLVED = 0, LANE_SOLVED, LANE_BROKEN };
+
+    BatchSolver();
+
+    //Copies the model's topology and makes room for lanes boards
+    void load(const BoardModel &model, int lanes);
+    //Loads the clues and fixed values of a board with the
+    //loaded topology into a lane. Everything else starts empty
+    void setLane(int lane, const BoardModel &model);
+    //Writes a lane's fixed values and candidates into a model
+    //with the loaded topology
+    void store(int lane, BoardModel &model) const;
+
+    //Fixes a cell of a lane on v
+    void fixCell(int lane, int cell, int v);
+    //Stops solving a lane, by marking it broken
+    void dropLane(int lane) { status[lane] = LANE_BROKEN; }
+
+    //Applies the rules to every lane until nothing changes
+    void propagate();
+
+    int getNumLanes() const { return lanes; }
+    int getNumCells() const { return numCells; }
+    bool isClue(int cell) const { return type[cell] == CLUE; }
+    LaneStatus getStatus(int lane) const { return LaneStatus(status[lane]); }
+    quint16 getMask(int lane, int cell) const { return mask[cell*lanes + lane]; }
+    bool getFixed(int lane, int cell) const { return fixed[cell*lanes + lane]; }
+
+private:
+    void markRunsDirty(int cell);
+    void pruneRunCombos(int run);
+    //The Solver's per-cell rules, one lane at a time
+    bool filterRunByCells(int run);
+    bool removeRunNakedSubsets(int run);
+    void updateStatus();
+
+    int numCells, numRuns, lanes;
+
+    //Topology, shared by every lane
+    quint8 *type;
+    int *downRun, *rightRun;
+    int *runFirst, *runStride, *runLength;
+
+    //Per lane, interleaved: index*lanes + lane
+    quint16 *mask;
+    quint8 *fixed;
+    qint16 *runClue;
+    quint16 *runCombos;
+
+    //Per lane
+    quint8 *status;
+    quint16 *allowed, *necessary;
+
+    //Runs to look at in the next sweep
+    quint8 *runDirty;
+
+    SolverArena arena;
+    //Not part of the arena, so it's kept from one load to the next
+    RunMemo runMemo;
+};
+
+#endif
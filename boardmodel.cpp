@@ -0,0 +1,130 @@
+/*
+ * boardmodel.cpp
+ * See boardmodel.h for more information
+ */
+
+#include "boardmodel.h"
+
+BoardModel::BoardModel() {
+    rows = cols = 0;
+}
+
+void BoardModel::load(int rows, int cols, const QVector<CellInfo> &info) {
+    this->rows = rows;
+    this->cols = cols;
+    int numCells = rows*cols;
+
+    type.resize(numCells);
+    value.resize(numCells);
+    mask.resize(numCells);
+    fixed.resize(numCells);
+    downClue.resize(numCells);
+    rightClue.resize(numCells);
+    downRun.fill(-1, numCells);
+    rightRun.fill(-1, numCells);
+
+    int numRuns = 0;
+    for (int i = 0; i < numCells; i++) {
+        type[i] = quint8(info[i].type);
+        fixed[i] = info[i].fixed;
+        value[i] = 0;
+        mask[i] = 0;
+        downClue[i] = rightClue[i] = 0;
+
+        if (info[i].type == CLUE) {
+            downClue[i] = info[i].valueOrClues[0];
+            rightClue[i] = info[i].valueOrClues[1];
+            if (downClue[i] && i+cols < numCells && info[i+cols].type == NONCLUE)
+                numRuns++;
+            if (rightClue[i] && (i+1)%cols != 0 && info[i+1].type == NONCLUE)
+                numRuns++;
+            continue;
+        }
+
+        value[i] = quint8(info[i].valueOrClues[0]);
+        for (int n = 1; n < 10; n++) {
+            if (info[i].notes[n])
+                mask[i] |= quint16(1 << n);
+        }
+    }
+
+    runFirst.resize(numRuns);
+    runStride.resize(numRuns);
+    runClue.resize(numRuns);
+    runLength.resize(numRuns);
+
+    //Make the runs and tell their cells about them
+    int run = 0;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int index = r*cols+c;
+            if (type[index] == NONCLUE)
+                continue;
+
+            //Down clue
+            if (downClue[index] && r+1 < rows && type[index+cols] == NONCLUE) {
+                int length = 0;
+                for (int r2 = r+1; r2 < rows && type[r2*cols+c] == NONCLUE; r2++) {
+                    downRun[r2*cols+c] = run;
+                    length++;
+                }
+                runFirst[run] = index+cols;
+                runStride[run] = cols;
+                runClue[run] = downClue[index];
+                runLength[run] = length;
+                run++;
+            }
+
+            //Right clue
+            if (rightClue[index] && c+1 < cols && type[index+1] == NONCLUE) {
+                int length = 0;
+                for (int c2 = c+1; c2 < cols && type[r*cols+c2] == NONCLUE; c2++) {
+                    rightRun[r*cols+c2] = run;
+                    length++;
+                }
+                runFirst[run] = index+1;
+                runStride[run] = 1;
+                runClue[run] = rightClue[index];
+                runLength[run] = length;
+                run++;
+            }
+        }
+    }
+}
+
+void BoardModel::store(QVector<CellInfo> &info) const {
+    int numCells = rows*cols;
+    info.resize(numCells);
+
+    for (int i = 0; i < numCells; i++) {
+        CellInfo &cellInfo = info[i];
+        cellInfo.type = CellType(type[i]);
+        cellInfo.fixed = fixed[i];
+        cellInfo.notes[0] = false;
+
+        if (type[i] == CLUE) {
+            cellInfo.valueOrClues[0] = downClue[i];
+            cellInfo.valueOrClues[1] = rightClue[i];
+            for (int n = 1; n < 10; n++) {
+                cellInfo.notes[n] = false;
+            }
+            continue;
+        }
+
+        cellInfo.valueOrClues[0] = value[i];
+        cellInfo.valueOrClues[1] = 0;
+        for (int n = 1; n < 10; n++) {
+            cellInfo.notes[n] = (mask[i] & (1 << n)) != 0;
+        }
+    }
+}
+
+void BoardModel::clearValues() {
+    int numCells = rows*cols;
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == CLUE || fixed[i])
+            continue;
+        value[i] = 0;
+        mask[i] = 0;
+    }
+}
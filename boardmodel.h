@@ -0,0 +1,56 @@
+/*
+ * boardmodel.h
+ *
+ * The BoardModel is a barebones, widget-free copy of a board,
+ * used by the Solver and the generator. Unlike cellArray (or a
+ * vector of CellInfos), it is kept in structure-of-arrays form:
+ * one contiguous array each for cell type, value, candidate mask,
+ * fixed flag and run IDs, so a pass over the whole board streams
+ * linearly through a few small arrays.
+ *
+ * Cells are indexed row-major (index = row*cols + col).
+ * A candidate mask has bit n set if n is in the cell's notes
+ * (or, for the Solver, if n is still possible).
+ *
+ * Runs are the clue groups. The cells of run i are
+ * runFirst[i] + k*runStride[i], for k < runLength[i].
+ * Clues of 0 don't make a run.
+ */
+
+#ifndef BOARDMODEL_H
+#define BOARDMODEL_H
+
+#include <QVector>
+#include "common.h"
+
+struct BoardModel {
+    BoardModel();
+
+    //Builds the topology and the cells from CellInfos
+    void load(int rows, int cols, const QVector<CellInfo> &info);
+    //Writes the cells back out as CellInfos
+    void store(QVector<CellInfo> &info) const;
+    //Clears the values and notes of nonfixed cells
+    void clearValues();
+
+    int getNumCells() const { return rows*cols; }
+    int getNumRuns() const { return runFirst.size(); }
+
+    int rows, cols;
+
+    //Per cell
+    QVector<quint8> type;
+    QVector<quint8> value;
+    QVector<quint16> mask;
+    QVector<quint8> fixed;
+    //Clues, for clue cells
+    QVector<int> downClue, rightClue;
+    //Runs the cell is in, -1 if none
+    QVector<int> downRun, rightRun;
+
+    //Per run
+    QVector<int> runFirst, runStride;
+    QVector<int> runClue, runLength;
+};
+
+#endif
@@ -5,11 +5,12 @@
 
 #include "cell.h"
 #include <QDebug>
-#include <QMouseEvent>
-#include <QStaticText>
+
+//Smallest cell sizes, in pixels, that notes and text are drawn at
+static const int MIN_NOTE_SIZE = 24;
+static const int MIN_TEXT_SIZE = 12;
 
 Cell::Cell(int s, int r, int c) {
-    this->setMouseTracking(true);
     selected = false;
     for (int i = 0; i < 10; i++) {
         notes[i] = 0;
@@ -18,171 +19,104 @@ Cell::Cell(int s, int r, int c) {
     downClue = rightClue = value = 0;
     numInDownSum = numInRightSum = 0;
     fixed = false;
+    conflict = false;
+    glyphs = 0;
     size = s;
     row = r;
     col = c;
-    label = new QLabel;
 }
 
-void Cell::makePixmap() {
-    QPixmap pixmap = QPixmap(size, size);
-    label->setPixmap(pixmap);
+void Cell::draw(QPainter &painter, qreal numberAlpha) {
+    if (type == 0) {
+        if (notes[0] == 0)
+            drawNonClue(painter, value, numberAlpha, 0.5);
+        else
+            drawNonClue(painter, value, 0.2, 1);
+    }
+    else {
+        drawClueBox(painter);
+    }
 }
 
-void Cell::fill(QColor c) {
-    QPixmap pixmap = *(label->pixmap());
+void Cell::drawNonClue(QPainter &painter, int v, qreal valueAlpha, qreal notesAlpha) {
+    painter.save();
 
-    QPainter painter(&pixmap);
-    painter.setBrush(QBrush(c, Qt::SolidPattern));
-    QRectF rect = label->rect();
-    painter.drawRect(rect);
-
-    label->setPixmap(pixmap);
-
-    drawBorder();
-}
-
-void Cell::drawBorder() {
-    QPixmap pixmap = *(label->pixmap());
-    QPainter painter(&pixmap);
+    //Background, highlight and border
+    painter.fillRect(0, 0, size, size, *colors[NONCLUECOLOR]);
+    if (selected)
+        painter.fillRect(1, 1, size-2, size-2, *colors[SELECTCOLOR]);
     painter.setPen(QPen(*colors[BORDERCOLOR], 0));
     painter.drawRect(0, 0, size-1, size-1);
-    label->setPixmap(pixmap);
-}
 
-void Cell::draw(qreal numberAlpha) {
-    if (label->pixmap()->width() == 0 ||
-            label->pixmap()->height() == 0)
-        return;
-
-    if (type == 0) {
-        if (notes[0] == 0) {
-            drawValue(numberAlpha);
-            drawNotes(0.5);
-        }
-        else {
-            drawValue(0.2);
-            drawNotes();
-        }
+    //Value
+    if (v && size < MIN_TEXT_SIZE) {
+        painter.setOpacity(valueAlpha);
+        int dot = qMax(size/3, 1);
+        painter.fillRect((size-dot)/2, (size-dot)/2, dot, dot,
+                         *colors[conflict ? CONFLICTCOLOR : NONCLUETEXTCOLOR]);
     }
-    else {
-        drawClueBox();
+    else if (v) {
+        painter.setOpacity(valueAlpha);
+        painter.drawPixmap(0, 0, glyphs->getDigit(v, conflict));
     }
-}
 
-void Cell::drawNotes(qreal alpha) {
-    QPixmap pixmap = *(label->pixmap());
-    QPainter painter(&pixmap);
-    QRectF rect;
-
-    //Set painter attributes
-    painter.setOpacity(alpha);
-    painter.setRenderHint(QPainter::TextAntialiasing);
-    painter.setFont(QFont("Arial", size*0.25, 60));
-    painter.setPen(*colors[NOTECOLOR]);
+    if (size < MIN_NOTE_SIZE) {
+        painter.restore();
+        return;
+    }
 
+    //Notes, packed into the 3x3 spots in order
+    painter.setOpacity(notesAlpha);
     int pos = 0;
     for (int i = 1; i <= 9; i++) {
         if (notes[i] == 0)
             continue;
-        rect = QRectF(QPointF(2+(pos%3*(size/3)), 1+(pos/3*(size/3))), QSizeF(size/3.5, size/3.5));
-        painter.drawText(rect, Qt::AlignCenter, QString::number(i));
+        QRectF rect = QRectF(QPointF(2+(pos%3*(size/3)), 1+(pos/3*(size/3))), QSizeF(size/3.5, size/3.5));
+        const QPixmap &glyph = glyphs->getNote(i);
+        painter.drawPixmap(rect.center() - QPointF(glyph.width()/2.0, glyph.height()/2.0), glyph);
         pos++;
     }
 
     if (notes[0] == 1 && pos == 0) {
+        painter.setRenderHint(QPainter::TextAntialiasing);
         painter.setFont(QFont("Arial", size*0.1, 60, 1));
         painter.setPen(*colors[NOTECOLOR]);
-        painter.drawText(label->rect(), Qt::AlignCenter, "type a note...");
+        painter.drawText(QRect(0, 0, size, size), Qt::AlignCenter, "type a note...");
     }
 
-    label->setPixmap(pixmap);
-}
-
-void Cell::drawValue(qreal alpha) {
-    drawValue(value, alpha);
+    painter.restore();
 }
 
-void Cell::drawValue(int v, qreal alpha) {
-    fill(*colors[NONCLUECOLOR]);
+void Cell::drawClueBox(QPainter &painter) {
+    painter.save();
 
-    QPixmap pixmap = *(label->pixmap());
-    QPainter painter(&pixmap);
-    QRectF rect = label->rect();
+    //The clue color covers the whole cell, border included
+    painter.fillRect(0, 0, size, size, *colors[CLUECOLOR]);
 
-    if (selected) {
-        painter.setPen(*colors[SELECTCOLOR]);
-        painter.setBrush(QBrush(*colors[SELECTCOLOR], Qt::SolidPattern));
-        painter.drawRect(1, 1, size-3, size-3);
-    }
-
-    if (v == 0) {
-        label->setPixmap(pixmap);
-        drawBorder();
+    if (size < MIN_TEXT_SIZE) {
+        painter.restore();
         return;
     }
 
-    //Set painter attributes
-    painter.setOpacity(alpha);
-    painter.setRenderHint(QPainter::TextAntialiasing);
-    painter.setFont(QFont("Arial", size*0.65));
-    //painter.setPen(Qt::black);
-    painter.setPen(*colors[NONCLUETEXTCOLOR]);
-
-    painter.drawText(rect, Qt::AlignCenter, QString::number(v));
-
-    label->setPixmap(pixmap);
-}
-
-void Cell::drawClueBox() {
-    drawClueBox(downClue, rightClue);
-}
-
-void Cell::drawClueBox(int dClue, int rClue) {
-    fill(QColor(Qt::white));
-
-    QPixmap pixmap = *(label->pixmap());
-    QPainter painter(&pixmap);
-
-    //Set painter attributes
-    painter.setRenderHint(QPainter::TextAntialiasing);
-    painter.setFont(QFont("Arial", size*0.3));
-
-    //Fill in black
-    painter.setPen(QPen(*colors[CLUECOLOR], 2));
-    painter.setBrush(QBrush(*colors[CLUECOLOR], Qt::SolidPattern));
-    painter.drawRect(label->rect());
-
-    painter.setPen(*colors[CLUETEXTCOLOR]);
-    if (dClue) {
-        QRectF bottomLeftRect = QRectF(QPointF(size/9, 0.5*size), QPointF(size/2, size));
+    if (downClue) {
         QPointF bottomLeftPoint(size/9, 0.5*size);
-        if (dClue < 10) bottomLeftPoint += QPointF(size/8, 0);
-
-        QStaticText d(QString::number(dClue));
-        d.setTextWidth(bottomLeftRect.width());
-        d.setTextFormat(Qt::RichText);
-        painter.drawStaticText(bottomLeftPoint, d);
+        if (downClue < 10) bottomLeftPoint += QPointF(size/8, 0);
+        painter.drawPixmap(bottomLeftPoint, glyphs->getClue(downClue));
     }
 
-    if (rClue) {
-        QRectF topRightRect = QRectF(QPointF(size/2-size/20, size/10), QPointF(size, size/2));
+    if (rightClue) {
         QPointF topRightPoint(size/2, size/20);
-        if (rClue < 10) topRightPoint += QPointF(size/8, 0);
-
-        QStaticText r(QString::number(rClue));
-        r.setTextWidth(topRightRect.width());
-        r.setTextFormat(Qt::RichText);
-        painter.drawStaticText(topRightPoint, r);
+        if (rightClue < 10) topRightPoint += QPointF(size/8, 0);
+        painter.drawPixmap(topRightPoint, glyphs->getClue(rightClue));
     }
 
     //Draw diagonal line
-    if (dClue || rClue) {
+    if (downClue || rightClue) {
         painter.setPen(QPen(*colors[CLUETEXTCOLOR], 1));
         painter.drawLine(QPointF(0.5, 0.5), QPointF(size-0.5, size-0.5));
     }
 
-    label->setPixmap(pixmap);
+    painter.restore();
 }
 
 void Cell::handleNumPress(int n) {
@@ -190,26 +124,35 @@ void Cell::handleNumPress(int n) {
         return;
     if (notes[0] == 0) {
         value = n;
-        draw();
     }
     else {
         notes[n] = !notes[n];
-        draw();
     }
 }
 
 void Cell::select() {
     selected = true;
     notes[0] = 0;
-
-    draw();
 }
 
 void Cell::unselect() {
     selected = false;
     notes[0] = 0;
+}
 
-    draw();
+void Cell::setNoteMask(quint16 m) {
+    for (int n = 1; n < 10; n++) {
+        notes[n] = (m & (1 << n)) != 0;
+    }
+}
+
+quint16 Cell::getNoteMask() const {
+    quint16 m = 0;
+    for (int n = 1; n < 10; n++) {
+        if (notes[n])
+            m |= quint16(1 << n);
+    }
+    return m;
 }
 
 void Cell::setValue(int v) {
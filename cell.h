@@ -7,35 +7,35 @@
  * colors it should use to draw itself. Data is set by
  * the cells PuzzleBoard after construction.
  *
- * To draw the cell, we'll give it a QLabel that will hold a QPixmap.
+ * Cells are plain data, not widgets. The PuzzleBoard paints
+ * the cells that are on screen, and a cell draws itself with
+ * the board's painter, translated so (0, 0) is its top left corner.
+ * Changing a cell's data doesn't redraw it; the PuzzleBoard
+ * keeps track of which cells changed and repaints them.
+ *
+ * Small cells are drawn with less detail: notes are left out
+ * below MIN_NOTE_SIZE, and below MIN_TEXT_SIZE values are
+ * drawn as a dot and clues are left out.
  */
 
 #ifndef CELL_H
 #define CELL_H
 
-#include <QWidget>
-#include <QLabel>
-#include <QPixmap>
 #include <QPainter>
+#include <QColor>
 #include <QString>
+#include "glyphcache.h"
 #include "common.h"
 
-class Cell : public QWidget {
-    Q_OBJECT
-
+class Cell {
 public:
     Cell(int s = 50, int r = 0, int c = 0);
 
-    //Display
-    void makePixmap();
-    void fill(QColor c);
-    void drawBorder();
-    void draw(qreal numberAlpha = 1);
-    void drawNotes(qreal alpha = 1);
-    void drawValue(qreal alpha = 1);
-    void drawValue(int v, qreal alpha = 1);
-    void drawClueBox();
-    void drawClueBox(int dClue, int rClue);
+    //Display. Each of these paints the whole cell in one pass
+    void draw(QPainter &painter, qreal numberAlpha = 1);
+    //Draws v (instead of the cell's value) over the notes
+    void drawNonClue(QPainter &painter, int v, qreal valueAlpha, qreal notesAlpha);
+    void drawClueBox(QPainter &painter);
     void handleNumPress(int n);
     void select();
     void unselect();
@@ -48,15 +48,18 @@ public:
     void setDownClue(int d) { downClue = d; }
     void setRightClue(int r) { rightClue = r; }
     void setNote(int i, bool v) { notes[i] = v; }
+    void setNoteMask(quint16 m);
     void setNumInDownSum(int x) { numInDownSum = x; }
     void setNumInRightSum(int x) { numInRightSum = x; }
     void setColor(int whichColor, QColor *c) { colors[whichColor] = c; }
+    void setGlyphCache(GlyphCache *g) { glyphs = g; }
     void setFixed(bool f) { fixed = f; }
-    void setRightCombos(QVector<QVector<int>> c) { rightCombos = c; }
-    void setDownCombos(QVector<QVector<int>> c) { downCombos = c; }
+    void setConflict(bool c) { conflict = c; }
 
     //Accessors
     bool getNote(int i = 0) const { return notes[i]; }
+    //Bit n is set if note n is on
+    quint16 getNoteMask() const;
     bool getType() const { return type; }
     int getSize() const { return size; }
     int getRow() const { return row; }
@@ -68,14 +71,11 @@ public:
     int getNumInDownSum() const { return numInDownSum; }
     int getNumInRightSum() const { return numInRightSum; }
     bool getFixed() const { return fixed; }
-    QLabel *getLabel() const { return label; }
-    QVector<QVector<int>> getRightCombos() { return rightCombos; }
-    QVector<QVector<int>> getDownCombos() { return downCombos; }
-
+    bool getConflict() const { return conflict; }
+    //Where the cell is on the board
+    QRect getRect() const { return QRect(col*size, row*size, size, size); }
 
 private:
-    QLabel *label;
-
     int size, row, col;
 
     //NONCLUE = 0, CLUE = 1
@@ -95,16 +95,18 @@ private:
     //If the cell is selected
     bool selected;
 
+    //If the cell's value is repeated in one of its
+    //runs, or its run can't add up anymore
+    bool conflict;
+
     //For clue-cells goals,
     //and for nonclue-cells metaknowledge
     int downClue, rightClue;
     int numInDownSum, numInRightSum;
 
-    //Combos possible, for clue cells
-    QVector<QVector<int>> rightCombos, downCombos;
-
-    //Colors
-    QColor *colors[7];
+    //Colors, and the board's pre-rendered text
+    QColor *colors[8];
+    GlyphCache *glyphs;
 };
 
 #endif
@@ -1,13 +1,15 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <QtGlobal>
+
 enum CellType { NONCLUE = 0, CLUE };
 
 enum Direction { UP = 0, RIGHT, DOWN, LEFT };
 
 enum Color_t { CLUECOLOR = 0, CLUETEXTCOLOR, NONCLUECOLOR,
                NONCLUETEXTCOLOR, NOTECOLOR, SELECTCOLOR,
-               BORDERCOLOR };
+               BORDERCOLOR, CONFLICTCOLOR };
 
 struct CellInfo {
     //Nonclue or clue
@@ -23,5 +25,74 @@ struct CellPos {
     int col;
 };
 
+//Outcome of a single brute force guess
+enum GuessOutcome { GUESS_FAILED = 0, GUESS_SOLVED };
+
+//Counters gathered while brute force searching
+struct SolveStats {
+    //Guessing steps taken (search nodes expanded)
+    int nodes;
+    //Deepest level of nested guesses
+    int maxDepth;
+    //Guesses that didn't work and were undone
+    int backtracks;
+    //Time spent restoring the board after bad guesses
+    qint64 restoreNsecs;
+    //Runs whose notes were found in the Solver's run memo, or not
+    int memoHits, memoMisses;
+};
+
+//How a solve (or generate) ended. UNFINISHED means logic alone
+//got stuck; the next three mean it was stopped early. OVERFLOWED
+//means the Solver ran out of room for its undo trail or guesses
+//(which is a sizing bug), and the board was left as logic got it
+enum SolveStatus { SOLVE_SOLVED = 0, SOLVE_UNSOLVABLE, SOLVE_UNFINISHED,
+                   SOLVE_CANCELLED, SOLVE_TIMED_OUT, SOLVE_OUT_OF_NODES,
+                   SOLVE_OVERFLOWED };
+
+//Limits on a solve (or generate), 0 for no limit. For generating,
+//nodes are the clue assignments tried
+struct SolveLimits {
+    int timeLimitMsecs;
+    int maxNodes;
+};
+
+//One guess made by the brute force, for the solve trace
+struct SolveTraceEntry {
+    int depth;
+    CellPos cell;
+    int digit;
+    GuessOutcome outcome;
+};
+
+//What made the solver change a cell, for the step log. START is a
+//cell's notes before any rule runs, and PEERS is a number removed
+//because it was placed elsewhere in the cell's run
+enum SolveRule { RULE_START = 0, RULE_PEERS, RULE_RANGE, RULE_LAST_IN_RUN,
+                 RULE_COMBOS, RULE_ONLY_PLACE, RULE_NAKED_SUBSET,
+                 RULE_ONE_NOTE, RULE_GUESS, RULE_UNDO };
+
+//One change the solver made to a cell. Replaying puts in
+//newMask/newValue, and rewinding puts back oldMask/oldValue
+struct SolveStep {
+    int cell;
+    quint16 oldMask, newMask;
+    quint8 oldValue, newValue;
+    quint8 rule;
+};
+
+//The rule that placed a hinted number. HINT_MISTAKE means the
+//player's numbers or notes already contradict the clues
+enum HintRule { HINT_NONE = 0, HINT_MISTAKE, HINT_ONE_NOTE,
+                HINT_LAST_IN_RUN, HINT_ONLY_PLACE };
+
+//The next number logic can place, or why there isn't one
+struct SolveHint {
+    //-1, -1 if no cell can be pointed at
+    CellPos cell;
+    int digit;
+    HintRule rule;
+};
+
 #endif
 
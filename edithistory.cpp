@@ -0,0 +1,53 @@
+/*
+ * edithistory.cpp
+ * See edithistory.h for more information
+ */
+
+#include "edithistory.h"
+
+EditHistory::EditHistory(int capacity) {
+    edits.resize(capacity);
+    clear();
+}
+
+void EditHistory::clear() {
+    first = count = done = 0;
+    moveStarting = true;
+}
+
+void EditHistory::record(int cell, int oldValue, quint16 oldNotes, int newValue, quint16 newNotes) {
+    if (oldValue == newValue && oldNotes == newNotes)
+        return;
+
+    //A new edit can't be followed by the old redos
+    count = done;
+
+    //Make room by dropping the oldest move. If the move being
+    //recorded filled the whole buffer by itself, what's left
+    //of it is undone on its own
+    if (count == edits.size()) {
+        dropOldestMove();
+        if (!count)
+            moveStarting = true;
+    }
+
+    Edit &edit = at(count);
+    edit.cell = cell;
+    edit.oldNotes = oldNotes;
+    edit.newNotes = newNotes;
+    edit.oldValue = quint8(oldValue);
+    edit.newValue = quint8(newValue);
+    edit.moveStart = moveStarting;
+    moveStarting = false;
+    count++;
+    done++;
+}
+
+void EditHistory::dropOldestMove() {
+    //Drop the first edit, then the rest of its move
+    do {
+        first = (first + 1) % edits.size();
+        count--;
+        done--;
+    } while (count && !at(0).moveStart);
+}
@@ -0,0 +1,60 @@
+/*
+ * edithistory.h
+ *
+ * The EditHistory holds the undo/redo history of the board being
+ * played. Instead of snapshots of the board, it keeps one small
+ * diff per changed cell (its index, and its value and notes before
+ * and after), in a ring buffer of fixed size. A move (one key
+ * press, drop or right click) can change several cells, so the
+ * first edit of each move is marked and moves are undone whole.
+ *
+ * When the buffer is full, the oldest move is dropped to make
+ * room, so the history never grows past its capacity no matter
+ * how long a game is played. Recording an edit after undoing
+ * drops the moves that could have been redone.
+ */
+
+#ifndef EDITHISTORY_H
+#define EDITHISTORY_H
+
+#include <QVector>
+
+class EditHistory {
+public:
+    struct Edit {
+        int cell;
+        quint16 oldNotes, newNotes;
+        quint8 oldValue, newValue;
+        bool moveStart;
+    };
+
+    EditHistory(int capacity = 16384);
+
+    void clear();
+
+    //The edits recorded from here to the next beginMove() are one move
+    void beginMove() { moveStarting = true; }
+    void record(int cell, int oldValue, quint16 oldNotes, int newValue, quint16 newNotes);
+
+    //Undoing or redoing a move is done an edit at a time: the
+    //move is done once undo() returns an edit that starts a move,
+    //or once the next edit to redo starts one
+    bool canUndo() const { return done > 0; }
+    bool canRedo() const { return done < count; }
+    const Edit &undo() { done--; return at(done); }
+    const Edit &redo() { done++; return at(done-1); }
+    const Edit &getNextRedo() const { return at(done); }
+
+private:
+    const Edit &at(int i) const { return edits[(first + i) % edits.size()]; }
+    Edit &at(int i) { return edits[(first + i) % edits.size()]; }
+    void dropOldestMove();
+
+    //Ring of edits, starting at first. done of the count
+    //edits in it are applied, the rest can be redone
+    QVector<Edit> edits;
+    int first, count, done;
+    bool moveStarting;
+};
+
+#endif
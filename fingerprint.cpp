@@ -0,0 +1,146 @@
+/*
+ * fingerprint.cpp
+ * See fingerprint.h for more information
+ */
+
+#include "fingerprint.h"
+
+//Clues take 7 bits each (sums go up to 45)
+static const quint16 CLUE_CODE = 0x8000;
+
+static inline quint16 clueCode(int down, int right) {
+    return quint16(CLUE_CODE | (down & 0x7F) << 7 | (right & 0x7F));
+}
+
+//Swaps the down and right sums of a clue code
+static inline quint16 transposeCode(quint16 code) {
+    if (!(code & CLUE_CODE))
+        return code;
+    return clueCode(code & 0x7F, (code >> 7) & 0x7F);
+}
+
+//SplitMix64's finalizer
+static inline quint64 mix(quint64 x) {
+    x ^= x >> 30;
+    x *= Q_UINT64_C(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= Q_UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+    return x;
+}
+
+CanonicalForm::CanonicalForm() {
+    rows = cols = 0;
+    transposed = false;
+    fingerprint = { 0, 0 };
+}
+
+CanonicalForm::CanonicalForm(const BoardModel &model) {
+    rows = model.rows;
+    cols = model.cols;
+    codes.resize(rows*cols);
+    for (int i = 0; i < rows*cols; i++) {
+        if (model.type[i] == CLUE)
+            codes[i] = clueCode(model.downClue[i], model.rightClue[i]);
+        else
+            codes[i] = model.fixed[i] ? model.value[i] : 0;
+    }
+    canonicalize();
+}
+
+CanonicalForm::CanonicalForm(int rows, int cols, const QVector<CellInfo> &cells) {
+    this->rows = rows;
+    this->cols = cols;
+    codes.resize(rows*cols);
+    for (int i = 0; i < rows*cols; i++) {
+        const CellInfo &info = cells[i];
+        if (info.type == CLUE)
+            codes[i] = clueCode(info.valueOrClues[0], info.valueOrClues[1]);
+        else
+            codes[i] = info.fixed ? quint16(info.valueOrClues[0]) : 0;
+    }
+    canonicalize();
+}
+
+int CanonicalForm::toCanonical(int index) const {
+    if (!transposed)
+        return index;
+    return (index%cols)*rows + index/cols;
+}
+
+int CanonicalForm::fromCanonical(int index) const {
+    if (!transposed)
+        return index;
+    return (index%rows)*cols + index/rows;
+}
+
+void CanonicalForm::canonicalize() {
+    //Compare the transpose to the board as it is, stopping
+    //at the first difference. Square boards that are their
+    //own transpose stay as they are
+    int order = 0;
+    if (cols != rows) {
+        order = cols < rows ? -1 : 1;
+    }
+    else {
+        for (int i = 0; i < rows*cols && !order; i++) {
+            //Cell i of the transpose is cell (c, r) of the board
+            quint16 t = transposeCode(codes[(i%cols)*cols + i/cols]);
+            if (t != codes[i])
+                order = t < codes[i] ? -1 : 1;
+        }
+    }
+
+    transposed = order < 0;
+    if (transposed) {
+        QVector<quint16> t(rows*cols);
+        for (int i = 0; i < rows*cols; i++) {
+            t[toCanonical(i)] = transposeCode(codes[i]);
+        }
+        codes = t;
+    }
+
+    makeFingerprint();
+}
+
+void CanonicalForm::makeFingerprint() {
+    //Two differently seeded hashes over the size and
+    //the codes, four codes at a time
+    quint64 lo = mix(Q_UINT64_C(0x9e3779b97f4a7c15) ^ quint64(getRows()) << 32 ^ quint64(getCols()));
+    quint64 hi = mix(Q_UINT64_C(0xc2b2ae3d27d4eb4f) + lo);
+
+    int n = codes.size();
+    for (int i = 0; i < n; i += 4) {
+        quint64 word = 0;
+        for (int k = 0; k < 4 && i+k < n; k++) {
+            word |= quint64(codes[i+k]) << 16*k;
+        }
+        lo = mix(lo ^ word);
+        hi = mix(hi + word*Q_UINT64_C(0xff51afd7ed558ccd));
+    }
+
+    fingerprint = { lo, hi };
+}
+
+bool FingerprintSet::insert(const Fingerprint &f) {
+    QMutexLocker locker(&mutex);
+    if (set.contains(f))
+        return false;
+    set.insert(f);
+    return true;
+}
+
+bool FingerprintSet::contains(const Fingerprint &f) const {
+    QMutexLocker locker(&mutex);
+    return set.contains(f);
+}
+
+int FingerprintSet::size() const {
+    QMutexLocker locker(&mutex);
+    return set.size();
+}
+
+void FingerprintSet::clear() {
+    QMutexLocker locker(&mutex);
+    set.clear();
+}
@@ -0,0 +1,87 @@
+/*
+ * fingerprint.h
+ *
+ * A Fingerprint is a 128-bit hash of a puzzle: its clue layout,
+ * its sums and its fixed numbers (but not the player's numbers
+ * or notes). It's taken from the puzzle's CanonicalForm, so a
+ * board and its transpose (which has the down clues as right
+ * clues and the other way around) get the same one. For a hash
+ * table, the low 64 bits are plenty; all 128 bits are compared
+ * to decide that two puzzles are the same.
+ *
+ * The CanonicalForm writes each cell as one code: a clue is its
+ * down and right sums, and a nonclue is its fixed number (0 if it
+ * isn't fixed). Of the board and its transpose, whichever has the
+ * smaller (rows, cols, codes) sequence is the canonical one.
+ *
+ * A FingerprintSet is a set of fingerprints that can be shared
+ * between threads; the generator uses one to not make a puzzle
+ * it (or the player) has seen before.
+ */
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <QVector>
+#include <QSet>
+#include <QMutex>
+#include "boardmodel.h"
+#include "common.h"
+
+struct Fingerprint {
+    quint64 lo, hi;
+
+    bool operator==(const Fingerprint &f) const { return lo == f.lo && hi == f.hi; }
+    bool operator!=(const Fingerprint &f) const { return !(*this == f); }
+};
+
+inline uint qHash(const Fingerprint &f, uint seed = 0) {
+    return uint(f.lo ^ (f.lo >> 32)) ^ seed;
+}
+
+class CanonicalForm {
+public:
+    CanonicalForm();
+    //Takes the clues and fixed cells of a board
+    CanonicalForm(const BoardModel &model);
+    CanonicalForm(int rows, int cols, const QVector<CellInfo> &cells);
+
+    //Size of the canonical board
+    int getRows() const { return transposed ? cols : rows; }
+    int getCols() const { return transposed ? rows : cols; }
+    //Whether the canonical board is the transpose of the original
+    bool isTransposed() const { return transposed; }
+    //Maps a cell index of the original board to the
+    //canonical board, and back
+    int toCanonical(int index) const;
+    int fromCanonical(int index) const;
+
+    //Codes of the canonical board's cells, row-major
+    const QVector<quint16> &getCodes() const { return codes; }
+    Fingerprint getFingerprint() const { return fingerprint; }
+
+private:
+    void canonicalize();
+    void makeFingerprint();
+
+    //Size of the original board
+    int rows, cols;
+    bool transposed;
+    QVector<quint16> codes;
+    Fingerprint fingerprint;
+};
+
+class FingerprintSet {
+public:
+    //Adds f, and returns whether it wasn't in the set already
+    bool insert(const Fingerprint &f);
+    bool contains(const Fingerprint &f) const;
+    int size() const;
+    void clear();
+
+private:
+    mutable QMutex mutex;
+    QSet<Fingerprint> set;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * glyphcache.cpp
+ * See glyphcache.h for more information
+ */
+
+#include "glyphcache.h"
+#include <QPainter>
+#include <QStaticText>
+#include <QtMath>
+
+GlyphCache::GlyphCache() {
+    size = 50;
+    for (int i = 0; i < 8; i++) {
+        colors[i] = 0;
+    }
+}
+
+void GlyphCache::setSize(int s) {
+    if (size == s)
+        return;
+    size = s;
+    invalidate();
+}
+
+void GlyphCache::setColor(int whichColor, QColor *c) {
+    colors[whichColor] = c;
+    invalidate();
+}
+
+void GlyphCache::invalidate() {
+    for (int v = 0; v < 10; v++) {
+        digits[0][v] = digits[1][v] = QPixmap();
+        notes[v] = QPixmap();
+    }
+    for (int clue = 0; clue < 46; clue++) {
+        clues[clue] = QPixmap();
+    }
+}
+
+const QPixmap &GlyphCache::getDigit(int v, bool conflict) {
+    QPixmap &glyph = digits[conflict][v];
+    if (!glyph.isNull())
+        return glyph;
+
+    glyph = QPixmap(size, size);
+    glyph.fill(Qt::transparent);
+    QPainter painter(&glyph);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.setFont(QFont("Arial", size*0.65));
+    painter.setPen(*colors[conflict ? CONFLICTCOLOR : NONCLUETEXTCOLOR]);
+    painter.drawText(QRectF(0, 0, size, size), Qt::AlignCenter, QString::number(v));
+    painter.end();
+
+    return glyph;
+}
+
+const QPixmap &GlyphCache::getNote(int v) {
+    QPixmap &glyph = notes[v];
+    if (!glyph.isNull())
+        return glyph;
+
+    //A note's spot is size/3.5 across, but its text can
+    //spill out of it, so leave some room around it
+    int side = size/2;
+    qreal spot = size/3.5;
+    glyph = QPixmap(side, side);
+    glyph.fill(Qt::transparent);
+    QPainter painter(&glyph);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.setFont(QFont("Arial", size*0.25, 60));
+    painter.setPen(*colors[NOTECOLOR]);
+    painter.drawText(QRectF((side-spot)/2, (side-spot)/2, spot, spot), Qt::AlignCenter, QString::number(v));
+    painter.end();
+
+    return glyph;
+}
+
+const QPixmap &GlyphCache::getClue(int clue) {
+    //Clues that can't be made from 1-9 (from a bad KAKString)
+    //aren't worth keeping
+    if (clue < 1 || clue > 45) {
+        scratch = makeClue(clue);
+        return scratch;
+    }
+
+    QPixmap &glyph = clues[clue];
+    if (glyph.isNull())
+        glyph = makeClue(clue);
+    return glyph;
+}
+
+QPixmap GlyphCache::makeClue(int clue) const {
+    QFont font("Arial", size*0.3);
+    //Clues are only a couple of digits, so they don't need a text width
+    QStaticText text(QString::number(clue));
+    text.setTextFormat(Qt::RichText);
+    text.prepare(QTransform(), font);
+
+    QPixmap glyph(qCeil(text.size().width()), qCeil(text.size().height()));
+    glyph.fill(Qt::transparent);
+    QPainter painter(&glyph);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.setFont(font);
+    painter.setPen(*colors[CLUETEXTCOLOR]);
+    painter.drawStaticText(0, 0, text);
+    painter.end();
+
+    return glyph;
+}
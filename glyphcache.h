@@ -0,0 +1,51 @@
+/*
+ * glyphcache.h
+ *
+ * The GlyphCache holds pre-rendered text for drawing cells:
+ * the digits 1-9 of cell values (in the normal and mistake
+ * colors), the note digits 1-9, and the clue numbers 1-45.
+ * Cells blit these instead of laying out and rasterizing text
+ * on every draw.
+ *
+ * Glyphs are made the first time they're asked for, for the
+ * current cell size and colors. Changing either drops them all.
+ */
+
+#ifndef GLYPHCACHE_H
+#define GLYPHCACHE_H
+
+#include <QPixmap>
+#include <QColor>
+#include "common.h"
+
+class GlyphCache {
+public:
+    GlyphCache();
+
+    //Mutators. Both drop every glyph made so far
+    void setSize(int s);
+    void setColor(int whichColor, QColor *c);
+    void invalidate();
+
+    //A cell-sized glyph, with v centered like a cell's value
+    const QPixmap &getDigit(int v, bool conflict);
+    //A glyph with note v centered in it. Its center goes on
+    //the center of the note's spot in the cell
+    const QPixmap &getNote(int v);
+    //A glyph for a clue, drawn from its top left corner
+    const QPixmap &getClue(int clue);
+
+private:
+    QPixmap makeClue(int clue) const;
+
+    int size;
+    QColor *colors[8];
+
+    //Null until they're first needed
+    QPixmap digits[2][10];
+    QPixmap notes[10];
+    QPixmap clues[46];
+    QPixmap scratch;
+};
+
+#endif
@@ -9,13 +9,37 @@ SOURCES += main.cpp\
         mainwindow.cpp \
     cell.cpp \
     puzzleboard.cpp \
-    combohelperdialog.cpp
+    combohelperdialog.cpp \
+    solver.cpp \
+    runmemo.cpp \
+    boardmodel.cpp \
+    maskkernels.cpp \
+    batchsolver.cpp \
+    solvetask.cpp \
+    runtracker.cpp \
+    glyphcache.cpp \
+    edithistory.cpp \
+    savetask.cpp \
+    fingerprint.cpp \
+    solutioncache.cpp
 
 HEADERS  += mainwindow.h \
     cell.h \
     puzzleboard.h \
     common.h \
-    combohelperdialog.h
+    combohelperdialog.h \
+    solver.h \
+    runmemo.h \
+    boardmodel.h \
+    maskkernels.h \
+    batchsolver.h \
+    solvetask.h \
+    runtracker.h \
+    glyphcache.h \
+    edithistory.h \
+    savetask.h \
+    fingerprint.h \
+    solutioncache.h
 
 FORMS    +=
 
@@ -23,3 +47,12 @@ RESOURCES += \
     resources.qrc
 
 CONFIG += c++11
+
+#"make check" builds and runs the tests, each a QtTest
+#project of its own under tests/
+check_solveralloc.commands = $(MKDIR) tests/solveralloc && cd tests/solveralloc && \
+    $(QMAKE) $$PWD/tests/solveralloc/solveralloc.pro && $(MAKE) check
+check_maskkernels.commands = $(MKDIR) tests/maskkernels && cd tests/maskkernels && \
+    $(QMAKE) $$PWD/tests/maskkernels/maskkernels.pro && $(MAKE) check
+check.depends = check_solveralloc check_maskkernels
+QMAKE_EXTRA_TARGETS += check_solveralloc check_maskkernels check
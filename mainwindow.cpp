@@ -5,11 +5,49 @@
 
 #include "mainwindow.h"
 #include "combohelperdialog.h"
+#include "solutioncache.h"
 #include <QDebug>
 #include <stdlib.h>
 #include <time.h>
 #include <QTextDocument>
 
+//The journal of a save file, and the one an autosave is replacing
+static QString getJournalName(const QString &fileName) {
+    return fileName + ".journal";
+}
+
+static QString getOldJournalName(const QString &fileName) {
+    return fileName + ".journal.old";
+}
+
+//Moves the journal out of the way of the moves after an
+//autosave. False if it couldn't, and it's left as it was
+static bool rotateJournal(const QString &journalName, const QString &oldJournalName) {
+    if (!QFile::exists(oldJournalName))
+        return QFile::rename(journalName, oldJournalName);
+
+    //The last autosave failed, so the old journal has moves
+    //the file doesn't. These moves go after them
+    QFile oldJournal(oldJournalName), newJournal(journalName);
+    if (!newJournal.open(QFile::ReadOnly) ||
+            !oldJournal.open(QFile::WriteOnly | QFile::Append))
+        return false;
+    QByteArray moves = newJournal.readAll();
+    if (oldJournal.write(moves) != moves.size() || !oldJournal.flush())
+        return false;
+    newJournal.close();
+    return newJournal.remove();
+}
+
+//A file in the app's data folder, or the working
+//directory if there isn't one
+static QString getDataFileName(const QString &name) {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (!dir.isEmpty() && QDir().mkpath(dir))
+        return dir + "/" + name;
+    return name;
+}
+
 MainWindow::MainWindow() {
     installEventFilter(this);
     this->setMouseTracking(true);
@@ -19,13 +57,26 @@ MainWindow::MainWindow() {
 
     AUTOSAVE_INTERVAL = 60;
     AUTOSAVE_DISPLAY_TIME = 3;
+    GENERATE_TIME_LIMIT = 60;
+    CHECK_TIME_LIMIT = 50;
     timerId = 0;
     board = 0;
+    scrollArea = 0;
+    task = 0;
+    saveTask = 0;
+    backupLock = 0;
+    savedGeneration = 0;
+    savePool.setMaxThreadCount(1);
+    replayingJournal = compactPending = false;
     newGameD = 0;
     settingsD = 0;
+    replayD = 0;
 
     setColorsDefault();
 
+    //Solutions from earlier sessions
+    SolutionCache::get().load(getDataFileName("solutions.cache"));
+
     makePuzzleBoard(QString("10x10 50 "
                             "- 7/0 34/0 - 28/0 23/0 41/0 - 32/0 10/0 "
                             "0/7 0 0 0/15 0 0 0 0/3 0 0 "
@@ -43,15 +94,48 @@ MainWindow::MainWindow() {
     createActions();
     createMenus();
     createToolBars();
+
+    //Once the window is up
+    QTimer::singleShot(0, this, SLOT(recoverBackups()));
 }
 
 MainWindow::~MainWindow() {
     killTimer(timerId);
+
+    //Don't leave a task running on a board that's gone
+    if (task) {
+        task->cancel();
+        QThreadPool::globalInstance()->waitForDone();
+        delete task;
+    }
+
+    //Let an autosave finish writing
+    savePool.waitForDone();
+    delete saveTask;
+    //The backup stays, to be offered next time
+    delete backupLock;
+
+    SolutionCache::get().save(getDataFileName("solutions.cache"));
 }
 
 void MainWindow::makePuzzleBoard(QString KAKString) {
+    //A solve of the old board can't be put on the new one
+    if (task && task->getType() != SolveTask::GENERATE_TASK)
+        task->cancel();
+
     if (!board) {
         board = new PuzzleBoard(KAKString);
+        connect(board, SIGNAL(boardSolved()), this, SLOT(boardSolved()));
+        connect(board, SIGNAL(cellChanged(int,int,int)), this, SLOT(journalCell(int,int,int)));
+        //Queued, so a board being loaded is marked saved first
+        connect(board, SIGNAL(cellsReplaced()), this, SLOT(compactJournal()), Qt::QueuedConnection);
+
+        //The keyboard is for the board, not for scrolling
+        scrollArea = new QScrollArea;
+        scrollArea->setFrameShape(QFrame::NoFrame);
+        scrollArea->setFocusPolicy(Qt::NoFocus);
+        scrollArea->setWidget(board);
+        setCentralWidget(scrollArea);
     }
     else {
         board->makeBoardFromKAKString(KAKString);
@@ -60,10 +144,9 @@ void MainWindow::makePuzzleBoard(QString KAKString) {
     if (timerId) killTimer(timerId);
     timerId = startTimer(1000);
 
-    setFixedSize(board->width()+0, board->height()+75);
-    setCentralWidget(board);
+    adjustWindowSize();
 
-    updateLastSavedKAKString(KAKString);
+    updateSavedGeneration();
     setBoardColors();
 }
 
@@ -76,6 +159,7 @@ void MainWindow::setColorsDefault() {
     colors[NOTECOLOR] = new QColor(95, 95, 95, 255);
     colors[SELECTCOLOR] = new QColor(121, 213, 252, 100);
     colors[BORDERCOLOR] = new QColor(0, 0, 0, 255);
+    colors[CONFLICTCOLOR] = new QColor(204, 0, 0, 255);
 }
 
 void MainWindow::newGame() {
@@ -136,6 +220,8 @@ void MainWindow::newGame() {
     //Connect all the buttons
     connect(makeButton, SIGNAL(clicked()), this, SLOT(makeNewGame()));
     connect(cancelButton, SIGNAL(clicked()), newGameD, SLOT(close()));
+    //Closing the dialog stops generating
+    connect(newGameD, SIGNAL(finished(int)), this, SLOT(cancelTask()));
 
     connect(rowCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(setNewRows()));
     connect(colCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(setNewCols()));
@@ -156,10 +242,10 @@ void MainWindow::newGame() {
 }
 
 void MainWindow::makeNewGame() {
-    if (!newGameD) return;
-    QString s = board->generateBoard(newRows, newCols);
-    makePuzzleBoard(s);
-    newGameD->close();
+    if (!newGameD || task) return;
+    SolveTask *generateTask = new SolveTask(newRows, newCols, board->getCellSize(), &seenBoards);
+    generateTask->setLimits({ GENERATE_TIME_LIMIT*1000, 0 });
+    startTask(generateTask);
 }
 
 void MainWindow::setNewRows() {
@@ -216,14 +302,14 @@ void MainWindow::loadFile(const QString &fileName) {
 
     makePuzzleBoard(saved);
     updateLastSavedFileName(fileName);
+    replayJournal(fileName);
+    //Don't generate a board that's been opened
+    seenBoards.insert(board->getFingerprint());
     updateStatusTimer();
 }
 
 bool MainWindow::areYouSure() {
-    QString currKAKString = board->getKAKString();
-    currKAKString.truncate(currKAKString.size()-9);
-
-    if (lastSavedKAKString != currKAKString) {
+    if (board->getGeneration() != savedGeneration) {
         QMessageBox::StandardButton ans;
         ans = QMessageBox::warning(this, tr("Kakuro"),
                                    tr("Do you want to save the current game?"),
@@ -241,16 +327,8 @@ bool MainWindow::save() {
     //never saved a file before, or you clicked
     //save when there was an backupFile
     if (lastSavedFileName.isEmpty() || !backupFile.isEmpty()) {
-        bool saved = saveAs();
-
-        //Delete autosaved file if it exists
-        if (!backupFile.isEmpty()) {
-            QFile file(backupFile);
-            file.remove();
-            backupFile = "";
-        }
-
-        return saved;
+        //The backup goes once it's saved somewhere else
+        return saveAs();
     }
 
     //If you already have a saved file, just save it
@@ -278,49 +356,224 @@ bool MainWindow::saveAs() {
 }
 
 bool MainWindow::saveFile(const QString &fileName) {
-    QFile file(fileName);
-    if (!file.open(QFile::WriteOnly | QFile::Text)) {
-        QMessageBox::warning(this, tr("Application"),
-                             tr("Cannot write file %1:\n%2.")
-                             .arg(fileName)
-                             .arg(file.errorString()));
-        return false;
-    }
-
-    QTextStream out(&file);
 #ifndef QT_NO_CURSOR
     QApplication::setOverrideCursor(Qt::WaitCursor);
 #endif
 
-    QString saved = board->getKAKString();
-    out << saved;
+    //An older autosave mustn't land on top of this save
+    savePool.waitForDone();
+
+    QString error;
+    bool saved = SaveTask::writeFile(fileName, board->getKAKString(), &error);
 
 #ifndef QT_NO_CURSOR
     QApplication::restoreOverrideCursor();
 #endif
 
-    updateLastSavedKAKString(saved);
-    lastSavedFileName = fileName;
+    if (!saved) {
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Cannot write file %1:\n%2.")
+                             .arg(fileName)
+                             .arg(error));
+        return false;
+    }
+
+    //The file has every move now
+    updateLastSavedFileName(fileName);
+    removeJournal(fileName);
+    updateSavedGeneration();
 
     return true;
 }
 
-void MainWindow::updateLastSavedKAKString(const QString &KAKstring) {
-    //If no KAKstring provided, just get it from the board
-    if (KAKstring == "" && board) {
-        lastSavedKAKString = board->getKAKString();
-        lastSavedKAKString.truncate(lastSavedKAKString.size() - 9);
+void MainWindow::updateSavedGeneration() {
+    if (board)
+        savedGeneration = board->getGeneration();
+}
+
+void MainWindow::startAutosave() {
+    //If there's no save file, use a backup one,
+    //named for this session, so it can't be another's
+    if (lastSavedFileName.isEmpty()) {
+        backupFile = getDataFileName(QString("autosave-%1-%2.kak")
+                                     .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))
+                                     .arg(QCoreApplication::applicationPid()));
+        backupLock = new QLockFile(backupFile + ".lock");
+        backupLock->tryLock(0);
+        updateLastSavedFileName(backupFile);
     }
-    else {
-        lastSavedKAKString = KAKstring;
-        //If there's a time, cut it out
-        if (lastSavedKAKString.contains(':')) {
-            lastSavedKAKString.truncate(lastSavedKAKString.size() - 9);
+
+    //Moves from here on go in a new journal. The old one
+    //is removed once the snapshot is written
+    QString journalName = getJournalName(lastSavedFileName);
+    QString oldJournalName = getOldJournalName(lastSavedFileName);
+    journal.close();
+    if (QFile::exists(journalName) && !rotateJournal(journalName, oldJournalName)) {
+        //Both journals are still there to be replayed
+        autoSaveLabel->setText("Autosave failed: cannot write " + oldJournalName);
+        return;
+    }
+
+    //The snapshot is taken here, and turned into a
+    //KAKString and written on the save pool
+    saveTask = new SaveTask(lastSavedFileName, board->getSnapshot(), board->getGeneration());
+    saveTask->setJournalToRemove(oldJournalName);
+    connect(saveTask, SIGNAL(finished()), this, SLOT(autosaveFinished()));
+    saveTask->start(&savePool);
+}
+
+void MainWindow::journalCell(int index, int value, int notes) {
+    if (replayingJournal)
+        return;
+
+    if (!journal.isOpen()) {
+        //Nothing to put it next to yet; the first
+        //autosave writes the whole board anyway
+        if (lastSavedFileName.isEmpty())
+            return;
+        journal.setFileName(getJournalName(lastSavedFileName));
+        if (!journal.open(QFile::WriteOnly | QFile::Append | QFile::Text))
+            return;
+    }
+
+    //Flushed every time, so a crash loses nothing
+    journal.write(QString("%1 %2 %3\n").arg(index).arg(value).arg(notes).toLatin1());
+    journal.flush();
+}
+
+void MainWindow::compactJournal() {
+    //Steps of a solve being replayed aren't saved
+    if (!board || board->getGeneration() == savedGeneration || replayD)
+        return;
+    //Once the running autosave is done
+    if (saveTask) {
+        compactPending = true;
+        return;
+    }
+    startAutosave();
+}
+
+void MainWindow::replayJournal(const QString &fileName) {
+    //An old journal is only left if its autosave never finished,
+    //so its moves come before the ones in the current journal
+    const QString names[2] = { getOldJournalName(fileName), getJournalName(fileName) };
+
+    replayingJournal = true;
+    for (int i = 0; i < 2; i++) {
+        QFile file(names[i]);
+        if (!file.open(QFile::ReadOnly | QFile::Text))
+            continue;
+
+        QTextStream in(&file);
+        while (!in.atEnd()) {
+            QStringList entry = in.readLine().split(' ');
+            if (entry.size() != 3)
+                continue;
+            board->applyJournalEntry(entry[0].toInt(), entry[1].toInt(), quint16(entry[2].toUInt()));
         }
     }
+    replayingJournal = false;
+
+    //Fold the moves into the file
+    compactJournal();
+}
+
+void MainWindow::removeJournal(const QString &fileName) {
+    if (getJournalName(fileName) == journal.fileName())
+        journal.close();
+    QFile::remove(getJournalName(fileName));
+    QFile::remove(getOldJournalName(fileName));
+}
+
+void MainWindow::discardBackup() {
+    //An autosave still writing it would put it back
+    savePool.waitForDone();
+    QFile::remove(backupFile);
+    removeJournal(backupFile);
+    delete backupLock;
+    backupLock = 0;
+    backupFile = "";
+}
+
+void MainWindow::recoverBackups() {
+    QString dir = QFileInfo(getDataFileName("autosave.kak")).absolutePath();
+    QFileInfoList backups = QDir(dir).entryInfoList(QStringList("autosave-*.kak"),
+                                                    QDir::Files, QDir::Time);
+
+    //Newest first, and only one is opened
+    bool recovered = false;
+    for (int i = 0; i < backups.size(); i++) {
+        QString fileName = backups.at(i).absoluteFilePath();
+
+        //Stale once its process is gone, however old it is.
+        //One that's still locked is another session's
+        QLockFile *lock = new QLockFile(fileName + ".lock");
+        lock->setStaleLockTime(0);
+        if (recovered || !lock->tryLock(0)) {
+            delete lock;
+            continue;
+        }
+
+        QMessageBox::StandardButton ans;
+        ans = QMessageBox::question(this, tr("Kakuro"),
+                                    tr("A game that wasn't saved was found, from %1. "
+                                       "Do you want to open it?")
+                                    .arg(backups.at(i).lastModified().toString()),
+                                    QMessageBox::Open | QMessageBox::Discard | QMessageBox::Ignore);
+        if (ans == QMessageBox::Open) {
+            loadFile(fileName);
+            if (lastSavedFileName == fileName) {
+                backupFile = fileName;
+                backupLock = lock;
+                recovered = true;
+                continue;
+            }
+        }
+        else if (ans == QMessageBox::Discard) {
+            QFile::remove(fileName);
+            removeJournal(fileName);
+        }
+        delete lock;
+    }
+}
+
+void MainWindow::autosaveFinished() {
+    if (!saveTask)
+        return;
+
+    SaveTask *doneTask = saveTask;
+    saveTask = 0;
+    doneTask->deleteLater();
+
+    if (compactPending) {
+        compactPending = false;
+        compactJournal();
+    }
+
+    if (!doneTask->getSaved()) {
+        autoSaveLabel->setText("Autosave failed: " + doneTask->getError());
+        return;
+    }
+
+    //The board may have been saved (or replaced) since
+    //the snapshot was taken, and that counts for more
+    if (doneTask->getFileName() == lastSavedFileName &&
+            doneTask->getGeneration() > savedGeneration)
+        savedGeneration = doneTask->getGeneration();
+
+    autoSaveLabel->setText("Autosaved at " +
+                           board->getTimeFormatted() +
+                           " to file " + doneTask->getFileName());
 }
 
 void MainWindow::updateLastSavedFileName(const QString &fileName) {
+    //The backup isn't needed once the board is elsewhere
+    if (!backupFile.isEmpty() && fileName != backupFile)
+        discardBackup();
+
+    //Moves from here on go in the new file's journal
+    if (fileName != lastSavedFileName)
+        journal.close();
     lastSavedFileName = fileName;
 }
 
@@ -419,43 +672,362 @@ void MainWindow::checkSolved() {
     QMessageBox::information(this, "Kakuro", info);
 }
 
+void MainWindow::boardSolved() {
+    statusBar()->showMessage(tr("Solved!"), 5000);
+}
+
+void MainWindow::showHint() {
+    if (!board || task)
+        return;
+
+    SolveHint hint = board->getHint();
+    if (hint.cell.row != -1) {
+        board->selectCell(hint.cell);
+        int size = board->getCellSize();
+        scrollArea->ensureVisible(hint.cell.col*size + size/2, hint.cell.row*size + size/2, size, size);
+    }
+
+    QString cell = tr("row %1, column %2").arg(hint.cell.row+1).arg(hint.cell.col+1);
+    QString info;
+    switch (hint.rule) {
+    case HINT_ONE_NOTE:
+        info = tr("The cell at %1 can only be %2.").arg(cell).arg(hint.digit);
+        break;
+    case HINT_LAST_IN_RUN:
+        info = tr("The cell at %1 is the last one in its sum, so it has to be %2.").arg(cell).arg(hint.digit);
+        break;
+    case HINT_ONLY_PLACE:
+        info = tr("Its sum needs a %2, and %1 is the only place it can go.").arg(cell).arg(hint.digit);
+        break;
+    case HINT_MISTAKE:
+        if (hint.cell.row == -1)
+            info = tr("Something on the board is wrong.");
+        else if (hint.digit)
+            info = tr("The %2 at %1 can't be right.").arg(cell).arg(hint.digit);
+        else
+            info = tr("The notes at %1 leave no possible number.").arg(cell);
+        break;
+    default:
+        info = board->checkSolved() ? tr("The board is already solved.") :
+                                      tr("No number can be worked out without guessing.");
+        break;
+    }
+
+    statusBar()->showMessage(info, 10000);
+}
+
 void MainWindow::checkSolvable() {
-    if (!board)
+    if (!board || task)
         return;
 
-    QString savedKAK = board->getKAKString();
+    //Most boards are answered right away. Only
+    //hand the hard ones to a background task
+    SolveStatus status = board->checkSolvable({ CHECK_TIME_LIMIT, 0 });
+    if (status == SOLVE_TIMED_OUT) {
+        startTask(new SolveTask(SolveTask::CHECK_TASK, board->getBoardModel(), false));
+        return;
+    }
 
     QString info;
-    if (board->solve()) {
+    if (status == SOLVE_SOLVED) {
         info = "This Kakuro is solvable.";
     }
+    else if (status == SOLVE_OVERFLOWED) {
+        info = "Gave up before finding a solution.";
+    }
     else {
         info = "Oops! This Kakuro is unsolvable.";
     }
 
-    board->makeBoardFromKAKString(savedKAK);
-
     QMessageBox::information(this, "Kakuro", info);
 }
 
 void MainWindow::solveBoard() {
-    if (!board)
+    if (!board || task)
+        return;
+
+    startTask(new SolveTask(SolveTask::SOLVE_TASK, board->getBoardModel(),
+                            board->getTraceEnabled()));
+}
+
+void MainWindow::startTask(SolveTask *newTask) {
+    task = newTask;
+    connect(task, SIGNAL(progress(int)), this, SLOT(taskProgress(int)));
+    connect(task, SIGNAL(finished()), this, SLOT(taskFinished()));
+
+    checkSolvableAct->setEnabled(false);
+    solveBoardAct->setEnabled(false);
+    cancelTaskAct->setEnabled(true);
+    statusBar()->showMessage(task->getType() == SolveTask::GENERATE_TASK ?
+                             tr("Generating...") : tr("Solving..."));
+
+    task->start();
+}
+
+void MainWindow::taskProgress(int amount) {
+    if (!task)
+        return;
+
+    if (task->getType() == SolveTask::GENERATE_TASK)
+        statusBar()->showMessage(tr("Generating... (%1 clue sets tried)").arg(amount));
+    else
+        statusBar()->showMessage(tr("Solving... (%1 guesses)").arg(amount));
+}
+
+void MainWindow::cancelTask() {
+    if (task)
+        task->cancel();
+}
+
+void MainWindow::taskFinished() {
+    if (!task)
+        return;
+
+    //Done with the task before anything else can start one
+    SolveTask *doneTask = task;
+    task = 0;
+    doneTask->deleteLater();
+
+    checkSolvableAct->setEnabled(true);
+    solveBoardAct->setEnabled(true);
+    cancelTaskAct->setEnabled(false);
+    statusBar()->clearMessage();
+
+    if (doneTask->getType() == SolveTask::GENERATE_TASK) {
+        //A new board isn't saved anywhere yet
+        if (!doneTask->getCancelled() && doneTask->getSolved()) {
+            makePuzzleBoard(doneTask->getKAKString());
+            updateLastSavedFileName("");
+        }
+        if (newGameD)
+            newGameD->close();
+        if (doneTask->getStatus() == SOLVE_TIMED_OUT) {
+            QMessageBox::information(this, "Kakuro",
+                                     tr("Couldn't generate a board in %1 seconds. "
+                                        "Try again, or try another size.")
+                                     .arg(GENERATE_TIME_LIMIT));
+        }
         return;
+    }
 
-    QString savedKAK = board->getKAKString();
+    if (doneTask->getCancelled()) {
+        statusBar()->showMessage(tr("Solving cancelled"), 3000);
+        return;
+    }
 
     QString info;
-    if (board->solve()) {
+    if (doneTask->getStatus() == SOLVE_TIMED_OUT ||
+            doneTask->getStatus() == SOLVE_OUT_OF_NODES ||
+            doneTask->getStatus() == SOLVE_OVERFLOWED) {
+        QMessageBox::information(this, "Kakuro", "Gave up before finding a solution.");
+        return;
+    }
+    if (doneTask->getType() == SolveTask::CHECK_TASK) {
+        if (doneTask->getSolved())
+            info = "This Kakuro is solvable.";
+        else
+            info = "Oops! This Kakuro is unsolvable.";
+
+        QMessageBox::information(this, "Kakuro", info);
+        return;
+    }
+
+    //Only a solve that's put on the board can be replayed on it
+    board->setSolveResults(doneTask->getStats(), doneTask->getTrace(),
+                           doneTask->getSolved() ? doneTask->getSteps() : QVector<SolveStep>());
+    if (doneTask->getSolved()) {
+        board->setFromBoardModel(doneTask->getModel());
         info = "Solved!";
     }
     else {
         info = "Oops! This Kakuro is unsolvable.";
-        board->makeBoardFromKAKString(savedKAK);
+    }
+
+    SolveStats stats = doneTask->getStats();
+    if (stats.nodes) {
+        info += QString("\n\nGuesses: %1, deepest guess: %2, backtracks: %3, "
+                        "time restoring: %4 ms")
+                .arg(stats.nodes)
+                .arg(stats.maxDepth)
+                .arg(stats.backtracks)
+                .arg(stats.restoreNsecs/1000000.0, 0, 'f', 2);
+    }
+    //How often the solver's run memo already knew a run
+    int memoLookups = stats.memoHits + stats.memoMisses;
+    if (memoLookups) {
+        info += QString("\n\nRun memo hits: %1 of %2 (%3%)")
+                .arg(stats.memoHits)
+                .arg(memoLookups)
+                .arg(100.0*stats.memoHits/memoLookups, 0, 'f', 1);
     }
 
     QMessageBox::information(this, "Kakuro", info);
 }
 
+void MainWindow::toggleAutoNotes() {
+    if (!board)
+        return;
+
+    board->setAutoNotes(autoNotesAct->isChecked());
+}
+
+void MainWindow::toggleSolveTrace() {
+    if (!board)
+        return;
+
+    board->setTraceEnabled(recordTraceAct->isChecked());
+    exportTraceAct->setEnabled(recordTraceAct->isChecked());
+    replayAct->setEnabled(recordTraceAct->isChecked());
+}
+
+void MainWindow::exportSolveTrace() {
+    if (!board)
+        return;
+
+    QString fName = QFileDialog::getSaveFileName(this,
+                                                 tr("Export solve trace"),
+                                                 "",
+                                                 "JSON files (*.json);;"
+                                                 "Binary trace files (*.ktrc)");
+    if (fName.isEmpty())
+        return;
+
+    if (!board->exportSolveTrace(fName)) {
+        QMessageBox::warning(this, tr("Kakuro"),
+                             tr("Cannot write file %1.").arg(fName));
+    }
+}
+
+void MainWindow::replaySolve() {
+    if (!board || task)
+        return;
+
+    if (!board->getNumSolveSteps()) {
+        QMessageBox::information(this, "Kakuro",
+                                 tr("Solve the board while recording the solve trace to replay it."));
+        return;
+    }
+
+    //Make the dialog
+    replayD = new QDialog;
+    replayD->setWindowTitle(tr("Replay solve"));
+    replayD->setFixedWidth(500);
+
+    //Create content
+    replayLabel = new QLabel;
+    replaySlider = new QSlider(Qt::Horizontal);
+    replaySlider->setRange(0, board->getNumSolveSteps());
+    replayTimer = new QTimer(replayD);
+
+    //Control buttons
+    replayPlayButton = new QPushButton(tr("Play"));
+    QPushButton *closeButton = new QPushButton(tr("Close"));
+    //Add buttons to their layout
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(replayPlayButton);
+    buttonLayout->addWidget(closeButton);
+    //Make a holder widget for buttons
+    QWidget *buttonWidget = new QWidget;
+    buttonWidget->setLayout(buttonLayout);
+
+    //Add everything to mainLayout
+    QVBoxLayout *mainLayout = new QVBoxLayout;
+    mainLayout->addWidget(replayLabel);
+    mainLayout->addWidget(replaySlider);
+    mainLayout->addWidget(buttonWidget);
+
+    replayD->setLayout(mainLayout);
+
+    //Connect everything
+    connect(replaySlider, SIGNAL(valueChanged(int)), this, SLOT(showReplayStep(int)));
+    connect(replayPlayButton, SIGNAL(clicked()), this, SLOT(toggleReplayPlaying()));
+    connect(replayTimer, SIGNAL(timeout()), this, SLOT(advanceReplay()));
+    connect(closeButton, SIGNAL(clicked()), replayD, SLOT(close()));
+
+    //Start from the empty board
+    replaySlider->setValue(0);
+    showReplayStep(0);
+
+    replayD->exec();
+
+    //Leave the board as the solve did
+    replayTimer->stop();
+    board->showSolveStep(board->getNumSolveSteps());
+    delete replayD;
+    replayD = 0;
+}
+
+void MainWindow::showReplayStep(int step) {
+    board->showSolveStep(step);
+
+    if (step == 0) {
+        replayLabel->setText(tr("Step 0 of %1: the empty board").arg(board->getNumSolveSteps()));
+        return;
+    }
+
+    //Describe the step that was just taken
+    static const char *ruleNames[] = {
+        QT_TR_NOOP("starting notes"), QT_TR_NOOP("used elsewhere in its sums"),
+        QT_TR_NOOP("out of range of its sums"), QT_TR_NOOP("last cell in its sum"),
+        QT_TR_NOOP("not in any combination"), QT_TR_NOOP("only place its sum needs it"),
+        QT_TR_NOOP("taken by other cells in its sum"), QT_TR_NOOP("only note left"),
+        QT_TR_NOOP("guess"), QT_TR_NOOP("guess undone")
+    };
+    const SolveStep &s = board->getSolveStep(step-1);
+    int cols = board->getCols();
+    QString change;
+    if (s.rule == RULE_UNDO) {
+        change = tr("put back");
+    }
+    else if (s.newValue && !s.oldValue) {
+        change = tr("placed %1").arg(s.newValue);
+    }
+    else {
+        QString removed, added;
+        for (int n = 1; n <= 9; n++) {
+            if ((s.oldMask & (1 << n)) && !(s.newMask & (1 << n)))
+                removed += QString::number(n);
+            if (!(s.oldMask & (1 << n)) && (s.newMask & (1 << n)))
+                added += QString::number(n);
+        }
+        change = added.isEmpty() ? tr("removed %1").arg(removed) : tr("notes %1").arg(added);
+    }
+
+    replayLabel->setText(tr("Step %1 of %2: row %3, column %4, %5 (%6)")
+                         .arg(step)
+                         .arg(board->getNumSolveSteps())
+                         .arg(s.cell/cols + 1)
+                         .arg(s.cell%cols + 1)
+                         .arg(change)
+                         .arg(tr(ruleNames[s.rule])));
+}
+
+void MainWindow::toggleReplayPlaying() {
+    if (replayTimer->isActive()) {
+        replayTimer->stop();
+        replayPlayButton->setText(tr("Play"));
+        return;
+    }
+
+    //Play again from the start if it's at the end
+    if (replaySlider->value() == replaySlider->maximum())
+        replaySlider->setValue(0);
+    replayTimer->start(REPLAY_INTERVAL);
+    replayPlayButton->setText(tr("Pause"));
+}
+
+void MainWindow::advanceReplay() {
+    //Long solves take more steps at a time,
+    //so no replay lasts much longer than 15 seconds
+    int stepsPerTick = qMax(1, board->getNumSolveSteps()/500);
+    replaySlider->setValue(replaySlider->value() + stepsPerTick);
+
+    if (replaySlider->value() == replaySlider->maximum()) {
+        replayTimer->stop();
+        replayPlayButton->setText(tr("Play"));
+    }
+}
+
 void MainWindow::comboHelper() {
     ComboHelperDialog *d = new ComboHelperDialog(board);
     d->show();
@@ -474,12 +1046,12 @@ void MainWindow::settings() {
     //Cell size combo box
     QLabel *cellSizeLabel = new QLabel(tr("Cell size:"));
     cellSizeCombo = new QComboBox;
-    for (int i = 20; i <= 100; i+=5) {
+    for (int i = MIN_CELL_SIZE; i <= MAX_CELL_SIZE; i+=5) {
         cellSizeCombo->addItem(QString::number(i) + "px", i);
     }
     QGroupBox *colorGroup = new QGroupBox(tr("Colors"));
     QLabel *colorInfo = new QLabel("Enter colors using hexadecimal format.");
-    QLabel *colorLabels[7];
+    QLabel *colorLabels[8];
     colorLabels[CLUECOLOR] = new QLabel(tr("Clue background color:"));
     colorLabels[NONCLUECOLOR] = new QLabel(tr("Non-clue background color:"));
     colorLabels[CLUETEXTCOLOR] = new QLabel(tr("Clue text color:"));
@@ -487,14 +1059,15 @@ void MainWindow::settings() {
     colorLabels[BORDERCOLOR] = new QLabel(tr("Border color:"));
     colorLabels[NOTECOLOR] = new QLabel(tr("Notes text color:"));
     colorLabels[SELECTCOLOR] = new QLabel(tr("Highlight color:"));
-    for (int i = 0; i < 7; i++) {
+    colorLabels[CONFLICTCOLOR] = new QLabel(tr("Mistake text color:"));
+    for (int i = 0; i < 8; i++) {
         colorLineEdits[i] = new QLineEdit;
         colorLineEdits[i]->setText(colors[i]->name());
     }
 
     QGridLayout *colorLayout = new QGridLayout;
     colorLayout->addWidget(colorInfo, 0, 0);
-    for (int i = 0; i < 7; i++) {
+    for (int i = 0; i < 8; i++) {
         colorLayout->addWidget(colorLabels[i], i+1, 0);
         colorLayout->addWidget(colorLineEdits[i], i+1, 1);
     }
@@ -548,11 +1121,11 @@ void MainWindow::settings() {
 
 void MainWindow::saveSettings() {
     //Set new cell size
-    board->setCellSize(newCellSize);
+    setCellSize(newCellSize);
 
     //Set new colors
     QColor colorHolder;
-    for (int i = 0; i < 7; i++) {
+    for (int i = 0; i < 8; i++) {
         colorHolder.setNamedColor(colorLineEdits[i]->text());
         if (colorHolder.isValid()) {
             colors[i]->setNamedColor(colorLineEdits[i]->text());
@@ -560,9 +1133,6 @@ void MainWindow::saveSettings() {
     }
     setBoardColors();
 
-    //Adjust sizes
-    setFixedSize(board->width()+0, board->height()+75);
-
     //Redraw board
     board->drawBoard();
 
@@ -571,7 +1141,7 @@ void MainWindow::saveSettings() {
 
 void MainWindow::restoreDefaultSettings() {
     setColorsDefault();
-    for (int i = 0; i < 7; i++) {
+    for (int i = 0; i < 8; i++) {
         colorLineEdits[i]->setText(colors[i]->name());
         board->setColor(i, colors[i]);
     }
@@ -581,7 +1151,7 @@ void MainWindow::setBoardColors() {
     if (!board)
         return;
 
-    for (int i = 0; i < 7; i++) {
+    for (int i = 0; i < 8; i++) {
         board->setColor(i, colors[i]);
     }
 }
@@ -644,15 +1214,67 @@ void MainWindow::createActions() {
     solveBoardAct->setStatusTip(tr("Solve the board"));
     connect(solveBoardAct, SIGNAL(triggered()), this, SLOT(solveBoard()));
 
+    hintAct = new QAction(tr("Hint"), this);
+    hintAct->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_H));
+    hintAct->setStatusTip(tr("Show the next number that can be worked out"));
+    connect(hintAct, SIGNAL(triggered()), this, SLOT(showHint()));
+
+    autoNotesAct = new QAction(tr("Auto notes"), this);
+    autoNotesAct->setStatusTip(tr("Keep the notes of empty cells up to date"));
+    autoNotesAct->setCheckable(true);
+    connect(autoNotesAct, SIGNAL(triggered()), this, SLOT(toggleAutoNotes()));
+
     comboHelpAct = new QAction(tr("Combo helper"), this);
     comboHelpAct->setStatusTip(tr("Open the combo helper"));
     connect(comboHelpAct, SIGNAL(triggered()), this, SLOT(comboHelper()));
 
+    recordTraceAct = new QAction(tr("Record solve trace"), this);
+    recordTraceAct->setStatusTip(tr("Record every guess and change the solver makes"));
+    recordTraceAct->setCheckable(true);
+    connect(recordTraceAct, SIGNAL(triggered()), this, SLOT(toggleSolveTrace()));
+
+    exportTraceAct = new QAction(tr("Export solve trace"), this);
+    exportTraceAct->setStatusTip(tr("Save the guesses of the last solve to a file"));
+    exportTraceAct->setEnabled(false);
+    connect(exportTraceAct, SIGNAL(triggered()), this, SLOT(exportSolveTrace()));
+
+    replayAct = new QAction(tr("Replay solve"), this);
+    replayAct->setStatusTip(tr("Step through the changes the last solve made"));
+    replayAct->setEnabled(false);
+    connect(replayAct, SIGNAL(triggered()), this, SLOT(replaySolve()));
+
+    cancelTaskAct = new QAction(tr("Stop solving"), this);
+    cancelTaskAct->setStatusTip(tr("Stop the solve that's running"));
+    cancelTaskAct->setShortcut(QKeySequence(Qt::Key_Escape));
+    cancelTaskAct->setEnabled(false);
+    connect(cancelTaskAct, SIGNAL(triggered()), this, SLOT(cancelTask()));
+
     //Settings
     settingsAct = new QAction(QIcon(":/res/settings.png"), tr("Settings"), this);
     settingsAct->setStatusTip(tr("Adjust settings"));
     connect(settingsAct, SIGNAL(triggered()), this, SLOT(settings()));
 
+    zoomInAct = new QAction(tr("Zoom in"), this);
+    zoomInAct->setShortcuts(QKeySequence::ZoomIn);
+    zoomInAct->setStatusTip(tr("Make the cells bigger"));
+    connect(zoomInAct, SIGNAL(triggered()), this, SLOT(zoomIn()));
+
+    zoomOutAct = new QAction(tr("Zoom out"), this);
+    zoomOutAct->setShortcuts(QKeySequence::ZoomOut);
+    zoomOutAct->setStatusTip(tr("Make the cells smaller"));
+    connect(zoomOutAct, SIGNAL(triggered()), this, SLOT(zoomOut()));
+
+    //Plain keys, since Ctrl and Shift on their own change the selected number
+    undoAct = new QAction(tr("Undo"), this);
+    undoAct->setShortcut(QKeySequence(Qt::Key_Z));
+    undoAct->setStatusTip(tr("Undo the last move"));
+    connect(undoAct, SIGNAL(triggered()), this, SLOT(undo()));
+
+    redoAct = new QAction(tr("Redo"), this);
+    redoAct->setShortcut(QKeySequence(Qt::Key_Y));
+    redoAct->setStatusTip(tr("Redo the last undone move"));
+    connect(redoAct, SIGNAL(triggered()), this, SLOT(redo()));
+
     resetAct = new QAction(QIcon(":/res/reset.png"), tr("Reset game"), this);
     resetAct->setStatusTip(tr("Reset the current game"));
     connect(resetAct, SIGNAL(triggered()), this, SLOT(reset()));
@@ -667,15 +1289,29 @@ void MainWindow::createMenus() {
     fileMenu->addSeparator();
     fileMenu->addAction(exitAct);
 
+    editMenu = menuBar()->addMenu(tr("&Edit"));
+    editMenu->addAction(undoAct);
+    editMenu->addAction(redoAct);
+
     solverMenu = menuBar()->addMenu(tr("Solver"));
     solverMenu->addAction(comboHelpAct);
     solverMenu->addAction(checkSolvedAct);
+    solverMenu->addAction(hintAct);
+    solverMenu->addAction(autoNotesAct);
     solverMenu->addAction(checkSolvableAct);
     solverMenu->addAction(solveBoardAct);
+    solverMenu->addAction(cancelTaskAct);
     solverMenu->addAction(resetAct);
+    solverMenu->addSeparator();
+    solverMenu->addAction(recordTraceAct);
+    solverMenu->addAction(exportTraceAct);
+    solverMenu->addAction(replayAct);
 
     settingsMenu = menuBar()->addMenu(tr("Settings"));
     settingsMenu->addAction(settingsAct);
+    settingsMenu->addSeparator();
+    settingsMenu->addAction(zoomInAct);
+    settingsMenu->addAction(zoomOutAct);
 
     helpMenu = menuBar()->addMenu(tr("&Help"));
     helpMenu->addAction(rulesAct);
@@ -724,27 +1360,12 @@ void MainWindow::timerEvent(QTimerEvent *event) {
     board->setSeconds(board->getSeconds()+1);
     updateStatusTimer();
 
-    //Autosave at intervals (if there's been a change)
+    //Autosave at intervals (if there's been a change, and
+    //the last autosave is done). Checking is just comparing
+    //generations, so an unchanged board costs nothing
     if (board->getSeconds()%AUTOSAVE_INTERVAL == 0) {
-        QString currStr = board->getKAKString();
-        currStr.truncate(currStr.size()-9);
-        if (lastSavedKAKString != currStr) {
-            //If there's no save file, make a backup one
-            if (lastSavedFileName.isEmpty()) {
-                backupFile = "backup" + QString::number(rand()%100000) + ".kak";
-                saveFile(backupFile);
-                autoSaveLabel->setText("Autosaved at " +
-                                       board->getTimeFormatted() +
-                                       " to file " + lastSavedFileName);
-                return;
-            }
-
-            //If there was a previous file (either back or user-created), use it
-            saveFile(lastSavedFileName);
-            autoSaveLabel->setText("Autosaved at " +
-                                   board->getTimeFormatted() +
-                                   " to file " + lastSavedFileName);
-        }
+        if (board->getGeneration() != savedGeneration && !saveTask && !replayD)
+            startAutosave();
     }
     //Clear the status bar label after a certain time
     if (board->getSeconds()%AUTOSAVE_INTERVAL == AUTOSAVE_DISPLAY_TIME) {
@@ -756,12 +1377,18 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
     //Don't let the user play if the clock is stopped
     if (!timerId) return false;
     if (!board) return false;
+    //or while the solver is working on the board
+    if (task && task->getType() == SolveTask::SOLVE_TASK) return false;
     //Send most mouse and keyboard inputs to the board
     if (event->type() == QEvent::MouseMove ||
             event->type() == QEvent::HoverMove ||
             event->type() == QEvent::MouseButtonPress ||
             event->type() == QEvent::MouseButtonRelease) {
-        if (board->rect().contains(board->mapFromGlobal(QCursor::pos()))) {
+        //Only the part of the board that's scrolled into view
+        QWidget *viewport = scrollArea->viewport();
+        QPoint cursor = QCursor::pos();
+        if (board->rect().contains(board->mapFromGlobal(cursor)) &&
+                viewport->rect().contains(viewport->mapFromGlobal(cursor))) {
             QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
             board->handleMouse(mouseEvent);
         }
@@ -769,6 +1396,77 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
     else if (event->type() == QEvent::KeyPress) {
         QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
         board->keyPressEvent(keyEvent);
+
+        //Keep the selected cell on screen
+        CellPos pos = board->getSelectedCell();
+        if (pos.row != -1 && pos.col != -1) {
+            int size = board->getCellSize();
+            scrollArea->ensureVisible(pos.col*size + size/2, pos.row*size + size/2, size, size);
+        }
     }
     return false;
 }
+
+void MainWindow::adjustWindowSize() {
+    //Room for the menu, toolbars and status bar
+    const int EXTRA_HEIGHT = 75;
+
+    //Boards bigger than the screen are scrolled
+    QRect screen = QApplication::desktop()->availableGeometry(this);
+    int maxWidth = screen.width() - 50;
+    int maxHeight = screen.height() - EXTRA_HEIGHT - 50;
+    int width = qMin(board->width(), maxWidth);
+    int height = qMin(board->height(), maxHeight);
+
+    //Make room for a scroll bar going the other way
+    int scrollBar = style()->pixelMetric(QStyle::PM_ScrollBarExtent);
+    if (board->height() > maxHeight)
+        width = qMin(width + scrollBar, maxWidth);
+    if (board->width() > maxWidth)
+        height = qMin(height + scrollBar, maxHeight);
+
+    setFixedSize(width, height + EXTRA_HEIGHT);
+}
+
+void MainWindow::setCellSize(int size) {
+    board->setCellSize(qBound(MIN_CELL_SIZE, size, MAX_CELL_SIZE));
+    adjustWindowSize();
+}
+
+void MainWindow::undo() {
+    //Same as playing: not while the clock or a solve is stopping it
+    if (!board || !timerId)
+        return;
+    if (task && task->getType() == SolveTask::SOLVE_TASK)
+        return;
+
+    if (!board->undo())
+        statusBar()->showMessage(tr("Nothing to undo"), 2000);
+}
+
+void MainWindow::redo() {
+    if (!board || !timerId)
+        return;
+    if (task && task->getType() == SolveTask::SOLVE_TASK)
+        return;
+
+    if (!board->redo())
+        statusBar()->showMessage(tr("Nothing to redo"), 2000);
+}
+
+void MainWindow::zoomIn() {
+    if (!board)
+        return;
+
+    //Steps of 5px, like the settings
+    int size = board->getCellSize();
+    setCellSize(size - size%5 + 5);
+}
+
+void MainWindow::zoomOut() {
+    if (!board)
+        return;
+
+    int size = board->getCellSize();
+    setCellSize((size + 4)/5*5 - 5);
+}
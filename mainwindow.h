@@ -4,8 +4,8 @@
  * The MainWindow class is the backbone of the application.
  * It holds all of the menus, toolbars, saving/loading
  * functions, settings, etc., and will hold a PuzzleBoard
- * as its central widget. Input on the PuzzleBoard is handled
- * in PuzzleBoard, not here.
+ * in a scroll area as its central widget. Input on the
+ * PuzzleBoard is handled in PuzzleBoard, not here.
  *
  * -----------------------------------------------------------
  *
@@ -38,6 +38,23 @@
  *
  * An example KAKString might look like this:
  * "3x3 50 - 12/0 3/0 0/11 0 0n12 0/4 3 1f t00:01:15"
+ *
+ * -----------------------------------------------------------
+ *
+ * Note on journals:
+ * Between autosaves, every cell a move changes is appended to a
+ * journal next to the save file ("$FILE.journal"), one line per
+ * cell: "$INDEX $VALUE $NOTES", where $INDEX is row*cols + col and
+ * $NOTES has bit n set for note n. Opening a file replays its
+ * journal on top of it.
+ * An autosave compacts the journal: it's renamed to
+ * "$FILE.journal.old" (new moves start a new journal), and removed
+ * once the whole board is written to the file. If that autosave
+ * failed, the next one appends the journal to the old one instead.
+ * A board that was never saved is autosaved to a backup in the app's
+ * data folder, "autosave-$TIME-$PID.kak", locked by "$FILE.lock" for
+ * as long as the session has it. A backup that isn't locked was left
+ * by a session that's gone, and is offered to be opened at startup.
  */
 
 #ifndef MAINWINDOW_H
@@ -46,6 +63,8 @@
 #include <QMainWindow>
 #include <QtWidgets>
 #include "puzzleboard.h"
+#include "solvetask.h"
+#include "savetask.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -66,6 +85,10 @@ private slots:
     void about();
     void reset();
     void settings();
+    void undo();
+    void redo();
+    void zoomIn();
+    void zoomOut();
 
     //Saving/loading
     void newGame();
@@ -79,9 +102,32 @@ private slots:
 
     //Solver
     void checkSolved();
+    void boardSolved();
+    void showHint();
+    void toggleAutoNotes();
     void checkSolvable();
     void solveBoard();
     void comboHelper();
+    void toggleSolveTrace();
+    void exportSolveTrace();
+
+    //Solve replay dialog
+    void replaySolve();
+    void showReplayStep(int step);
+    void toggleReplayPlaying();
+    void advanceReplay();
+
+    //Autosaving
+    void autosaveFinished();
+    void journalCell(int index, int value, int notes);
+    void compactJournal();
+    //Offers to open the backups earlier sessions left
+    void recoverBackups();
+
+    //Background solving/generating
+    void taskProgress(int amount);
+    void taskFinished();
+    void cancelTask();
 
     //New game dialog
     void setNewRows();
@@ -101,19 +147,55 @@ private:
     void createMenus();
     void createToolBars();
     void createStatusBar();
+    //Fits the window to the board, up to the size of the screen
+    void adjustWindowSize();
+    void setCellSize(int size);
 
     //Saving/loading
     bool areYouSure();
     void loadFile(const QString &fileName);
     bool saveFile(const QString &fileName);
-    void updateLastSavedKAKString(const QString &KAKstring = "");
+    //Marks the board as saved as it is now
+    void updateSavedGeneration();
+    void startAutosave();
+    void replayJournal(const QString &fileName);
+    void removeJournal(const QString &fileName);
+    //Removes this session's backup, and its journals
+    void discardBackup();
     void updateLastSavedFileName(const QString &fileName);
 
+    //Background solving/generating
+    void startTask(SolveTask *newTask);
+
     PuzzleBoard *board;
+    //Scrolls boards that don't fit on the screen
+    QScrollArea *scrollArea;
+    //Only one task runs at a time
+    SolveTask *task;
 
     //Saving/loading
-    QString lastSavedKAKString, lastSavedFileName, backupFile;
+    QString lastSavedFileName, backupFile;
+    //Held while backupFile is this session's
+    QLockFile *backupLock;
+    //The board's generation when it was last saved or loaded
+    quint64 savedGeneration;
+    //Autosaves are written one at a time on their own pool,
+    //so a save can wait for them without waiting for a solve
+    SaveTask *saveTask;
+    QThreadPool savePool;
+    //Journal of lastSavedFileName, opened on the first move after
+    //each autosave. compactPending is whether the board changed
+    //all at once while an autosave was running
+    QFile journal;
+    bool replayingJournal, compactPending;
+    //Boards generated or opened this session, which
+    //the generator won't make again
+    FingerprintSet seenBoards;
     int AUTOSAVE_INTERVAL, AUTOSAVE_DISPLAY_TIME;
+    //Longest we'll try to generate a board for, in seconds
+    int GENERATE_TIME_LIMIT;
+    //Longest a solvability check blocks before moving to the background, in ms
+    int CHECK_TIME_LIMIT;
 
     //Timer
     int timerId;
@@ -124,15 +206,27 @@ private:
     QComboBox *rowCombo, *colCombo;
     int newRows, newCols;
 
+    //Solve replay dialog
+    QDialog *replayD;
+    QSlider *replaySlider;
+    QLabel *replayLabel;
+    QPushButton *replayPlayButton;
+    QTimer *replayTimer;
+    //How often the replay moves on, in ms
+    const int REPLAY_INTERVAL = 30;
+
     //Settings dialog
     QDialog *settingsD;
+    //Smallest cells can be zoomed out to, and biggest zoomed in to
+    const int MIN_CELL_SIZE = 5, MAX_CELL_SIZE = 100;
     QComboBox *cellSizeCombo;
     int newCellSize;
-    QLineEdit *colorLineEdits[7];
-    QColor *colors[7];
+    QLineEdit *colorLineEdits[8];
+    QColor *colors[8];
 
     //Menus/toolbars
     QMenu *fileMenu;
+    QMenu *editMenu;
     QMenu *solverMenu;
     QMenu *settingsMenu;
     QMenu *helpMenu;
@@ -144,6 +238,8 @@ private:
     QAction *checkSolvedAct;
     QAction *checkSolvableAct;
     QAction *solveBoardAct;
+    QAction *hintAct;
+    QAction *autoNotesAct;
     QAction *newAct;
     QAction *openAct;
     QAction *saveAct;
@@ -153,8 +249,14 @@ private:
     QAction *aboutAct;
     QAction *startTimerAct, *pauseTimerAct;
     QAction *resetAct;
+    QAction *undoAct, *redoAct;
     QAction *settingsAct;
+    QAction *zoomInAct, *zoomOutAct;
     QAction *comboHelpAct;
+    QAction *recordTraceAct;
+    QAction *exportTraceAct;
+    QAction *replayAct;
+    QAction *cancelTaskAct;
 
 };
 
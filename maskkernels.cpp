@@ -0,0 +1,408 @@
+/*
+ * maskkernels.cpp
+ * See maskkernels.h for more information
+ */
+
+#include "maskkernels.h"
+
+#if defined(Q_PROCESSOR_X86) && defined(Q_CC_GNU)
+#define MASKKERNELS_X86
+#include <immintrin.h>
+#endif
+
+//Scalar versions. These do lanes from laneBegin on, so
+//the SIMD versions can use them for the leftover lanes
+
+static inline bool isSingle(quint16 m) {
+    return m && !(m & (m - 1));
+}
+
+static inline int lowestNote(quint16 m) {
+    int lo = 10;
+    for (int d = 9; d >= 1; d--) {
+        if (m & (1 << d))
+            lo = d;
+    }
+    return lo;
+}
+
+static inline int highestNote(quint16 m) {
+    int hi = 0;
+    for (int d = 1; d < 10; d++) {
+        if (m & (1 << d))
+            hi = d;
+    }
+    return hi;
+}
+
+static bool filterByCombosLanes(quint16 *masks, int lanes, int laneBegin, int first,
+                                int stride, int length, const quint16 *allowed) {
+    bool changed = false;
+    for (int l = laneBegin; l < lanes; l++) {
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            quint16 &m = masks[i*lanes + l];
+            quint16 n = m & allowed[l];
+            changed |= n != m;
+            m = n;
+        }
+    }
+    return changed;
+}
+
+static bool forceDigitsLanes(quint16 *masks, int lanes, int laneBegin, int first,
+                             int stride, int length, const quint16 *necessary) {
+    bool changed = false;
+    for (int l = laneBegin; l < lanes; l++) {
+        //Values seen in at least one, and at least two cells
+        quint16 once = 0, twice = 0, singles = 0;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            quint16 m = masks[i*lanes + l];
+            twice |= once & m;
+            once |= m;
+            if (isSingle(m))
+                singles |= m;
+        }
+        quint16 hidden = necessary[l] & once & ~twice;
+
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            quint16 &m = masks[i*lanes + l];
+            quint16 n = m;
+            if (m & hidden)
+                n = m & hidden;
+            else if (!isSingle(m))
+                n = m & ~singles;
+            changed |= n != m;
+            m = n;
+        }
+    }
+    return changed;
+}
+
+static bool adjustByRangeLanes(quint16 *masks, int lanes, int laneBegin, int first,
+                               int stride, int length, const qint16 *clues) {
+    bool changed = false;
+    for (int l = laneBegin; l < lanes; l++) {
+        int minNoteSum = 0, maxNoteSum = 0;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            quint16 m = masks[i*lanes + l];
+            minNoteSum += lowestNote(m);
+            maxNoteSum += highestNote(m);
+        }
+
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            quint16 &m = masks[i*lanes + l];
+            int cellMin = clues[l] - (maxNoteSum - highestNote(m));
+            int cellMax = clues[l] - (minNoteSum - lowestNote(m));
+            quint16 allowed = 0;
+            for (int d = 1; d < 10; d++) {
+                if (d >= cellMin && d <= cellMax)
+                    allowed |= quint16(1 << d);
+            }
+            quint16 n = m & allowed;
+            changed |= n != m;
+            m = n;
+        }
+    }
+    return changed;
+}
+
+static bool filterByCombosScalar(quint16 *masks, int lanes, int first, int stride,
+                                 int length, const quint16 *allowed) {
+    return filterByCombosLanes(masks, lanes, 0, first, stride, length, allowed);
+}
+
+static bool forceDigitsScalar(quint16 *masks, int lanes, int first, int stride,
+                              int length, const quint16 *necessary) {
+    return forceDigitsLanes(masks, lanes, 0, first, stride, length, necessary);
+}
+
+static bool adjustByRangeScalar(quint16 *masks, int lanes, int first, int stride,
+                                int length, const qint16 *clues) {
+    return adjustByRangeLanes(masks, lanes, 0, first, stride, length, clues);
+}
+
+static const MaskKernels scalarKernels = {
+    "scalar", 1, filterByCombosScalar, forceDigitsScalar, adjustByRangeScalar
+};
+
+#ifdef MASKKERNELS_X86
+
+//SSE2 versions, 8 lanes at a time
+
+#define SSE2 __attribute__((target("sse2")))
+
+SSE2 static inline __m128i selectSSE2(__m128i sel, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(sel, a), _mm_andnot_si128(sel, b));
+}
+
+SSE2 static inline bool anySetSSE2(__m128i v) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF;
+}
+
+//All ones where a mask has exactly one bit set
+SSE2 static inline __m128i isSingleSSE2(__m128i m) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lowBitOnly = _mm_cmpeq_epi16(_mm_and_si128(m, _mm_sub_epi16(m, _mm_set1_epi16(1))), zero);
+    return _mm_andnot_si128(_mm_cmpeq_epi16(m, zero), lowBitOnly);
+}
+
+SSE2 static inline void noteRangeSSE2(__m128i m, __m128i &lo, __m128i &hi) {
+    lo = _mm_set1_epi16(10);
+    hi = _mm_setzero_si128();
+    for (int d = 1; d < 10; d++) {
+        __m128i bit = _mm_set1_epi16(short(1 << d));
+        hi = selectSSE2(_mm_cmpeq_epi16(_mm_and_si128(m, bit), bit), _mm_set1_epi16(short(d)), hi);
+    }
+    for (int d = 9; d >= 1; d--) {
+        __m128i bit = _mm_set1_epi16(short(1 << d));
+        lo = selectSSE2(_mm_cmpeq_epi16(_mm_and_si128(m, bit), bit), _mm_set1_epi16(short(d)), lo);
+    }
+}
+
+SSE2 static bool filterByCombosSSE2(quint16 *masks, int lanes, int first, int stride,
+                                    int length, const quint16 *allowed) {
+    __m128i changed = _mm_setzero_si128();
+    int l = 0;
+    for (; l + 8 <= lanes; l += 8) {
+        __m128i allow = _mm_loadu_si128(reinterpret_cast<const __m128i *>(allowed + l));
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m128i *p = reinterpret_cast<__m128i *>(masks + i*lanes + l);
+            __m128i m = _mm_loadu_si128(p);
+            __m128i n = _mm_and_si128(m, allow);
+            changed = _mm_or_si128(changed, _mm_xor_si128(m, n));
+            _mm_storeu_si128(p, n);
+        }
+    }
+    bool tailChanged = filterByCombosLanes(masks, lanes, l, first, stride, length, allowed);
+    return anySetSSE2(changed) || tailChanged;
+}
+
+SSE2 static bool forceDigitsSSE2(quint16 *masks, int lanes, int first, int stride,
+                                 int length, const quint16 *necessary) {
+    __m128i changed = _mm_setzero_si128();
+    int l = 0;
+    for (; l + 8 <= lanes; l += 8) {
+        __m128i once = _mm_setzero_si128(), twice = once, singles = once;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(masks + i*lanes + l));
+            twice = _mm_or_si128(twice, _mm_and_si128(once, m));
+            once = _mm_or_si128(once, m);
+            singles = _mm_or_si128(singles, _mm_and_si128(isSingleSSE2(m), m));
+        }
+        __m128i nec = _mm_loadu_si128(reinterpret_cast<const __m128i *>(necessary + l));
+        __m128i hidden = _mm_andnot_si128(twice, _mm_and_si128(nec, once));
+
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m128i *p = reinterpret_cast<__m128i *>(masks + i*lanes + l);
+            __m128i m = _mm_loadu_si128(p);
+            __m128i h = _mm_and_si128(m, hidden);
+            __m128i hasHidden = _mm_andnot_si128(_mm_cmpeq_epi16(h, _mm_setzero_si128()),
+                                                 _mm_set1_epi16(-1));
+            __m128i n = selectSSE2(isSingleSSE2(m), m, _mm_andnot_si128(singles, m));
+            n = selectSSE2(hasHidden, h, n);
+            changed = _mm_or_si128(changed, _mm_xor_si128(m, n));
+            _mm_storeu_si128(p, n);
+        }
+    }
+    bool tailChanged = forceDigitsLanes(masks, lanes, l, first, stride, length, necessary);
+    return anySetSSE2(changed) || tailChanged;
+}
+
+SSE2 static bool adjustByRangeSSE2(quint16 *masks, int lanes, int first, int stride,
+                                   int length, const qint16 *clues) {
+    __m128i changed = _mm_setzero_si128();
+    int l = 0;
+    for (; l + 8 <= lanes; l += 8) {
+        __m128i minNoteSum = _mm_setzero_si128(), maxNoteSum = minNoteSum;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(masks + i*lanes + l));
+            __m128i lo, hi;
+            noteRangeSSE2(m, lo, hi);
+            minNoteSum = _mm_add_epi16(minNoteSum, lo);
+            maxNoteSum = _mm_add_epi16(maxNoteSum, hi);
+        }
+        __m128i clue = _mm_loadu_si128(reinterpret_cast<const __m128i *>(clues + l));
+
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m128i *p = reinterpret_cast<__m128i *>(masks + i*lanes + l);
+            __m128i m = _mm_loadu_si128(p);
+            __m128i lo, hi;
+            noteRangeSSE2(m, lo, hi);
+            __m128i cellMin = _mm_sub_epi16(clue, _mm_sub_epi16(maxNoteSum, hi));
+            __m128i cellMax = _mm_sub_epi16(clue, _mm_sub_epi16(minNoteSum, lo));
+            __m128i allowed = _mm_setzero_si128();
+            for (int d = 1; d < 10; d++) {
+                __m128i dv = _mm_set1_epi16(short(d));
+                __m128i outside = _mm_or_si128(_mm_cmpgt_epi16(cellMin, dv),
+                                               _mm_cmpgt_epi16(dv, cellMax));
+                allowed = _mm_or_si128(allowed, _mm_andnot_si128(outside, _mm_set1_epi16(short(1 << d))));
+            }
+            __m128i n = _mm_and_si128(m, allowed);
+            changed = _mm_or_si128(changed, _mm_xor_si128(m, n));
+            _mm_storeu_si128(p, n);
+        }
+    }
+    bool tailChanged = adjustByRangeLanes(masks, lanes, l, first, stride, length, clues);
+    return anySetSSE2(changed) || tailChanged;
+}
+
+static const MaskKernels sse2Kernels = {
+    "SSE2", 8, filterByCombosSSE2, forceDigitsSSE2, adjustByRangeSSE2
+};
+
+//AVX2 versions, 16 lanes at a time
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i selectAVX2(__m256i sel, __m256i a, __m256i b) {
+    return _mm256_or_si256(_mm256_and_si256(sel, a), _mm256_andnot_si256(sel, b));
+}
+
+AVX2 static inline bool anySetAVX2(__m256i v) {
+    return !_mm256_testz_si256(v, v);
+}
+
+AVX2 static inline __m256i isSingleAVX2(__m256i m) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lowBitOnly = _mm256_cmpeq_epi16(_mm256_and_si256(m, _mm256_sub_epi16(m, _mm256_set1_epi16(1))), zero);
+    return _mm256_andnot_si256(_mm256_cmpeq_epi16(m, zero), lowBitOnly);
+}
+
+AVX2 static inline void noteRangeAVX2(__m256i m, __m256i &lo, __m256i &hi) {
+    lo = _mm256_set1_epi16(10);
+    hi = _mm256_setzero_si256();
+    for (int d = 1; d < 10; d++) {
+        __m256i bit = _mm256_set1_epi16(short(1 << d));
+        hi = selectAVX2(_mm256_cmpeq_epi16(_mm256_and_si256(m, bit), bit), _mm256_set1_epi16(short(d)), hi);
+    }
+    for (int d = 9; d >= 1; d--) {
+        __m256i bit = _mm256_set1_epi16(short(1 << d));
+        lo = selectAVX2(_mm256_cmpeq_epi16(_mm256_and_si256(m, bit), bit), _mm256_set1_epi16(short(d)), lo);
+    }
+}
+
+AVX2 static bool filterByCombosAVX2(quint16 *masks, int lanes, int first, int stride,
+                                    int length, const quint16 *allowed) {
+    __m256i changed = _mm256_setzero_si256();
+    int l = 0;
+    for (; l + 16 <= lanes; l += 16) {
+        __m256i allow = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(allowed + l));
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m256i *p = reinterpret_cast<__m256i *>(masks + i*lanes + l);
+            __m256i m = _mm256_loadu_si256(p);
+            __m256i n = _mm256_and_si256(m, allow);
+            changed = _mm256_or_si256(changed, _mm256_xor_si256(m, n));
+            _mm256_storeu_si256(p, n);
+        }
+    }
+    bool tailChanged = filterByCombosLanes(masks, lanes, l, first, stride, length, allowed);
+    return anySetAVX2(changed) || tailChanged;
+}
+
+AVX2 static bool forceDigitsAVX2(quint16 *masks, int lanes, int first, int stride,
+                                 int length, const quint16 *necessary) {
+    __m256i changed = _mm256_setzero_si256();
+    int l = 0;
+    for (; l + 16 <= lanes; l += 16) {
+        __m256i once = _mm256_setzero_si256(), twice = once, singles = once;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(masks + i*lanes + l));
+            twice = _mm256_or_si256(twice, _mm256_and_si256(once, m));
+            once = _mm256_or_si256(once, m);
+            singles = _mm256_or_si256(singles, _mm256_and_si256(isSingleAVX2(m), m));
+        }
+        __m256i nec = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(necessary + l));
+        __m256i hidden = _mm256_andnot_si256(twice, _mm256_and_si256(nec, once));
+
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m256i *p = reinterpret_cast<__m256i *>(masks + i*lanes + l);
+            __m256i m = _mm256_loadu_si256(p);
+            __m256i h = _mm256_and_si256(m, hidden);
+            __m256i hasHidden = _mm256_andnot_si256(_mm256_cmpeq_epi16(h, _mm256_setzero_si256()),
+                                                    _mm256_set1_epi16(-1));
+            __m256i n = selectAVX2(isSingleAVX2(m), m, _mm256_andnot_si256(singles, m));
+            n = selectAVX2(hasHidden, h, n);
+            changed = _mm256_or_si256(changed, _mm256_xor_si256(m, n));
+            _mm256_storeu_si256(p, n);
+        }
+    }
+    bool tailChanged = forceDigitsLanes(masks, lanes, l, first, stride, length, necessary);
+    return anySetAVX2(changed) || tailChanged;
+}
+
+AVX2 static bool adjustByRangeAVX2(quint16 *masks, int lanes, int first, int stride,
+                                   int length, const qint16 *clues) {
+    __m256i changed = _mm256_setzero_si256();
+    int l = 0;
+    for (; l + 16 <= lanes; l += 16) {
+        __m256i minNoteSum = _mm256_setzero_si256(), maxNoteSum = minNoteSum;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(masks + i*lanes + l));
+            __m256i lo, hi;
+            noteRangeAVX2(m, lo, hi);
+            minNoteSum = _mm256_add_epi16(minNoteSum, lo);
+            maxNoteSum = _mm256_add_epi16(maxNoteSum, hi);
+        }
+        __m256i clue = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(clues + l));
+
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            __m256i *p = reinterpret_cast<__m256i *>(masks + i*lanes + l);
+            __m256i m = _mm256_loadu_si256(p);
+            __m256i lo, hi;
+            noteRangeAVX2(m, lo, hi);
+            __m256i cellMin = _mm256_sub_epi16(clue, _mm256_sub_epi16(maxNoteSum, hi));
+            __m256i cellMax = _mm256_sub_epi16(clue, _mm256_sub_epi16(minNoteSum, lo));
+            __m256i allowed = _mm256_setzero_si256();
+            for (int d = 1; d < 10; d++) {
+                __m256i dv = _mm256_set1_epi16(short(d));
+                __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi16(cellMin, dv),
+                                                  _mm256_cmpgt_epi16(dv, cellMax));
+                allowed = _mm256_or_si256(allowed, _mm256_andnot_si256(outside, _mm256_set1_epi16(short(1 << d))));
+            }
+            __m256i n = _mm256_and_si256(m, allowed);
+            changed = _mm256_or_si256(changed, _mm256_xor_si256(m, n));
+            _mm256_storeu_si256(p, n);
+        }
+    }
+    bool tailChanged = adjustByRangeLanes(masks, lanes, l, first, stride, length, clues);
+    return anySetAVX2(changed) || tailChanged;
+}
+
+static const MaskKernels avx2Kernels = {
+    "AVX2", 16, filterByCombosAVX2, forceDigitsAVX2, adjustByRangeAVX2
+};
+
+#endif
+
+static QVector<const MaskKernels *> findKernels() {
+    QVector<const MaskKernels *> kernels;
+    kernels.append(&scalarKernels);
+#ifdef MASKKERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        kernels.append(&sse2Kernels);
+    if (__builtin_cpu_supports("avx2"))
+        kernels.append(&avx2Kernels);
+#endif
+    return kernels;
+}
+
+const QVector<const MaskKernels *> &MaskKernels::getAvailable() {
+    static const QVector<const MaskKernels *> kernels = findKernels();
+    return kernels;
+}
+
+const MaskKernels &MaskKernels::get(int lanes) {
+    //Kernels wider than the lanes would only run their scalar tail
+    const QVector<const MaskKernels *> &kernels = getAvailable();
+    int best = 0;
+    for (int n = 1; n < kernels.size(); n++) {
+        if (kernels[n]->width <= lanes)
+            best = n;
+    }
+    return *kernels[best];
+}
+
+const MaskKernels &MaskKernels::scalar() {
+    return scalarKernels;
+}
@@ -0,0 +1,57 @@
+/*
+ * maskkernels.h
+ *
+ * MaskKernels are the simple candidate mask rules of the Solver,
+ * applied to one run of many boards at once. The boards share a
+ * topology, and their masks are lane-interleaved: the mask of cell
+ * i in board (lane) l is masks[i*lanes + l], so the masks of one
+ * cell across all boards are contiguous and fit wide registers.
+ *
+ * There is a scalar version of every kernel, and SSE2 and AVX2
+ * versions on x86 that do 8 and 16 lanes at a time (and leave
+ * the rest to the scalar code). get() picks the widest ones the
+ * CPU supports that fill at least one block of lanes.
+ *
+ * Solved cells are masks with a single bit, and a mask of 0 is
+ * a contradiction. The kernels don't check for contradictions,
+ * they just return whether any mask changed.
+ */
+
+#ifndef MASKKERNELS_H
+#define MASKKERNELS_H
+
+#include <QtGlobal>
+#include <QVector>
+
+struct MaskKernels {
+    //Name of the instruction set, for display
+    const char *name;
+    //Lanes done at once
+    int width;
+
+    //Removes notes not in allowed[lane] (the union of the run's
+    //possible combos) from every cell of the run
+    bool (*filterByCombos)(quint16 *masks, int lanes, int first, int stride,
+                           int length, const quint16 *allowed);
+
+    //Sets cells that are the only ones with a value in
+    //necessary[lane] (the values in every possible combo),
+    //and removes the values of solved cells from the others
+    bool (*forceDigits)(quint16 *masks, int lanes, int first, int stride,
+                        int length, const quint16 *necessary);
+
+    //Removes notes outside of clues[lane] - (sum of the other
+    //cells' max notes) and clues[lane] - (sum of the other
+    //cells' min notes)
+    bool (*adjustByRange)(quint16 *masks, int lanes, int first, int stride,
+                          int length, const qint16 *clues);
+
+    //The best kernels for this CPU and this many lanes,
+    //and the plain C++ ones
+    static const MaskKernels &get(int lanes);
+    static const MaskKernels &scalar();
+    //Every set this CPU can run, narrowest first
+    static const QVector<const MaskKernels *> &getAvailable();
+};
+
+#endif
@@ -4,13 +4,21 @@
  */
 
 #include "puzzleboard.h"
+#include "solutioncache.h"
 #include <QPainter>
-#include <QPixmap>
 #include <QString>
 #include <QDebug>
 #include <QMouseEvent>
 #include <QKeyEvent>
+#include <QPaintEvent>
 #include <QTimer>
+#include <QFile>
+#include <QDataStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtAlgorithms>
+#include <QElapsedTimer>
 #include <cstdlib>
 #include <ctime>
 
@@ -41,17 +49,27 @@ void removeSpaces(QString & s) {
 
 //Used for board generation
 void floodFill(int index, QVector<bool> & filled, QVector<bool> map, int rows, int cols);
+//Clue assignments solved together in phase three of generating
+static const int GENERATE_BATCH = 8;
+//Why generating has to stop early, or SOLVE_SOLVED if it doesn't
+static SolveStatus getGenerateStopStatus(const CancelToken *token, const SolveLimits &limits,
+                                         const QElapsedTimer &timer, int assignmentsTried);
 
 PuzzleBoard::PuzzleBoard(QString s) {
     srand(time(NULL));
     this->setMouseTracking(true);
 
     seconds = 0;
+    generation = 0;
     selectedCell = draggingCell = { -1, -1 };
+    hoverCell = pendingHoverCell = { -1, -1 };
+    mouseMoveTimer.start();
     cellSize = 50;
-    cellArray = 0;
-    gridLayout = 0;
     rows = cols = 1;
+    traceEnabled = false;
+    autoNotes = false;
+    solveStats = { 0, 0, 0, 0, 0, 0 };
+    replayStep = 0;
 
     //Set colors default
     colors[CLUECOLOR] = new QColor(0, 0, 0, 255);
@@ -61,6 +79,11 @@ PuzzleBoard::PuzzleBoard(QString s) {
     colors[NOTECOLOR] = new QColor(95, 95, 95, 255);
     colors[SELECTCOLOR] = new QColor(121, 213, 252, 100);
     colors[BORDERCOLOR] = new QColor(0, 0, 0, 255);
+    colors[CONFLICTCOLOR] = new QColor(204, 0, 0, 255);
+    for (int i = 0; i < 8; i++) {
+        glyphCache.setColor(i, colors[i]);
+    }
+    glyphCache.setSize(cellSize);
 
     //Make the board
     makeBoardFromKAKString(s);
@@ -70,52 +93,37 @@ PuzzleBoard::PuzzleBoard(QString s) {
 }
 
 PuzzleBoard::~PuzzleBoard() {
-    for (int r = 0; r < rows; r++) {
-        delete [] cellArray[r];
-    }
-    delete [] cellArray;
 }
 
 void PuzzleBoard::makeNewCellArray(int newRows, int newCols) {
-    if (rows == newRows && cols == newCols)
+    if (rows == newRows && cols == newCols && cellPool.size() == rows*cols)
         return;
 
-    //Delete old cellArray
-    if (cellArray) {
-        for (int r = 0; r < rows; r++)
-            delete [] cellArray[r];
-        delete [] cellArray;
-    }
-    //Delete old layout
-    if (gridLayout) {
-        delete gridLayout;
-    }
-    //Create new layout
-    gridLayout = new QGridLayout;
-    gridLayout->setSpacing(0);
-    gridLayout->setContentsMargins(0, 0, 0, 0);
-    setLayout(gridLayout);
-
-    //Create new cellArray
+    //The pool grows to the biggest board loaded so far, and keeps
+    //its memory when a smaller one is loaded (QVector doesn't give
+    //back capacity on resize), so switching boards doesn't allocate
     rows = newRows;
     cols = newCols;
-    cellArray = new Cell*[rows];
+    cellPool.resize(rows*cols);
+    cellArray.resize(rows);
     for (int r = 0; r < rows; r++) {
-        cellArray[r] = new Cell[cols];
+        cellArray[r] = cellPool.data() + r*cols;
     }
-    //Put each cell on the grid,
-    //update its settings, and draw it
+    //The old cells are gone, and so is anything pointing at them
+    selectedCell = draggingCell = { -1, -1 };
+    hoverCell = pendingHoverCell = { -1, -1 };
+
+    //Reset each cell, update its settings, and draw it
     for (int r = 0; r < rows; r++) {
         for (int c = 0; c < cols; c++) {
-            cellArray[r][c].setSize(cellSize);
-            cellArray[r][c].setRowCol(r, c);
-            cellArray[r][c].makePixmap();
-            for (int i = 0; i < 7; i++) {
+            cellArray[r][c] = Cell(cellSize, r, c);
+            for (int i = 0; i < 8; i++) {
                 cellArray[r][c].setColor(i, colors[i]);
             }
-            gridLayout->addWidget(cellArray[r][c].getLabel(), r, c);
+            cellArray[r][c].setGlyphCache(&glyphCache);
         }
     }
+    markAllDirty();
 }
 
 void PuzzleBoard::setColor(int whichColor, QColor *color) {
@@ -125,6 +133,8 @@ void PuzzleBoard::setColor(int whichColor, QColor *color) {
             cellArray[r][c].setColor(whichColor, colors[whichColor]);
         }
     }
+    glyphCache.setColor(whichColor, colors[whichColor]);
+    markAllDirty();
 }
 
 void PuzzleBoard::initSumInNumCombos() {
@@ -383,7 +393,7 @@ void PuzzleBoard::makeBoardFromKAKString(QString s) {
     s.remove(0, 1);
     newCols = getUInt(s);
     removeSpaces(s);
-    cellSize = getUInt(s);
+    int newCellSize = getUInt(s);
     removeSpaces(s);
 
     int v;
@@ -490,15 +500,21 @@ void PuzzleBoard::makeBoardFromKAKString(QString s) {
         }
     }
 
+    //A replay of the last board's solve doesn't fit this one,
+    //and neither does its history
+    solveSteps.clear();
+    replayStep = 0;
+    history.clear();
+
     makeNewCellArray(newRows, newCols);
+    setCellSize(newCellSize);
     updateCellArray();
     giveMetaKnowledgeToCells();
+    boardModel.load(rows, cols, cellsInfo);
+    updateRunTracker();
 
     //Set size of board
     setFixedSize(newCols*cellSize, newRows*cellSize);
-
-    //Draw the board
-    QTimer::singleShot(25, this, SLOT(drawBoard()));
 }
 
 void PuzzleBoard::updateCellArray() {
@@ -511,19 +527,29 @@ void PuzzleBoard::updateCellArray(QVector<CellInfo> info) {
 
     while (index != info.size()) {
         cellInfo = info[index];
+        Cell *cellPtr = &cellArray[index/cols][index%cols];
+        //Only cells that change need redrawing
+        bool changed = cellPtr->getType() != bool(cellInfo.type) ||
+                cellPtr->getFixed() != cellInfo.fixed;
         if (cellInfo.type == CLUE) {
-            cellArray[index/cols][index%cols].setType(CLUE);
-            cellArray[index/cols][index%cols].setDownClue(cellInfo.valueOrClues[0]);
-            cellArray[index/cols][index%cols].setRightClue(cellInfo.valueOrClues[1]);
+            changed |= cellPtr->getDownClue() != cellInfo.valueOrClues[0] ||
+                    cellPtr->getRightClue() != cellInfo.valueOrClues[1];
+            cellPtr->setType(CLUE);
+            cellPtr->setDownClue(cellInfo.valueOrClues[0]);
+            cellPtr->setRightClue(cellInfo.valueOrClues[1]);
         }
         else if (cellInfo.type == NONCLUE) {
-            cellArray[index/cols][index%cols].setType(NONCLUE);
-            cellArray[index/cols][index%cols].setValue(cellInfo.valueOrClues[0]);
+            changed |= cellPtr->getValue() != cellInfo.valueOrClues[0];
+            cellPtr->setType(NONCLUE);
+            cellPtr->setValue(cellInfo.valueOrClues[0]);
             for (int i = 0; i < 10; i++) {
-                cellArray[index/cols][index%cols].setNote(i, cellInfo.notes[i]);
+                changed |= cellPtr->getNote(i) != cellInfo.notes[i];
+                cellPtr->setNote(i, cellInfo.notes[i]);
             }
         }
-        cellArray[index/cols][index%cols].setFixed(cellInfo.fixed);
+        cellPtr->setFixed(cellInfo.fixed);
+        if (changed)
+            markDirty({ index/cols, index%cols });
         index++;
     }
 }
@@ -555,13 +581,23 @@ QVector<CellInfo> PuzzleBoard::getCellsInfoFromCellArray() const {
 }
 
 QString PuzzleBoard::getKAKString() const {
-    QString s = convertCellsInfoToKAKString(rows, cols, getCellsInfoFromCellArray());
+    return makeKAKString(getSnapshot());
+}
+
+PuzzleBoard::Snapshot PuzzleBoard::getSnapshot() const {
+    Snapshot snapshot = { rows, cols, cellSize, getCellsInfoFromCellArray(), getTimeFormatted() };
+    return snapshot;
+}
+
+QString PuzzleBoard::makeKAKString(const Snapshot &snapshot) {
+    QString s = convertCellsInfoToKAKString(snapshot.rows, snapshot.cols,
+                                            snapshot.cellSize, snapshot.cells);
     s.remove(s.size()-8, 9);
-    s += getTimeFormatted();
+    s += snapshot.time;
     return s;
 }
 
-QString PuzzleBoard::convertCellsInfoToKAKString(int rows, int cols, QVector<CellInfo> info) const {
+QString PuzzleBoard::convertCellsInfoToKAKString(int rows, int cols, int cellSize, QVector<CellInfo> info) {
     QString s;
     s += QString::number(rows) + "x" + QString::number(cols);
     s += " " + QString::number(cellSize) + " ";
@@ -572,1336 +608,323 @@ QString PuzzleBoard::convertCellsInfoToKAKString(int rows, int cols, QVector<Cel
             dClue = info[i].valueOrClues[0];
             rClue = info[i].valueOrClues[1];
             if (dClue || rClue) {
-                s += QString::number(dClue) + "/" +
-                        QString::number(rClue) + " ";
-            }
-            else {
-                s += "- ";
-            }
-        }
-        else if (info[i].type == NONCLUE) {
-            v = info[i].valueOrClues[0];
-            s += QString::number(v);
-
-            //Does it have any notes?
-            bool hasAnyNotes = false;
-            for (int n = 1; n < 10; n++) {
-                if (info[i].notes[n]) {
-                    hasAnyNotes = true;
-                    break;
-                }
-            }
-
-            if (hasAnyNotes) {
-                s += 'n';
-                //Add each noted number
-                for (int n = 1; n < 10; n++) {
-                    if (info[i].notes[n])
-                        s += QString::number(n);
-                }
-            }
-            else if (info[i].fixed) {
-                s += 'f';
-            }
-
-            s += " ";
-        }
-    }
-
-    s += "t00:00:00";
-
-    return s;
-}
-
-void PuzzleBoard::clearBoard() {
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == CLUE)
-                continue;
-            if (cellArray[r][c].getFixed())
-                continue;
-            cellArray[r][c].setValue(0);
-            for (int i = 0; i < 10; i++)
-                cellArray[r][c].setNote(i, 0);
-            cellArray[r][c].draw();
-        }
-    }
-    cellsInfo = getCellsInfoFromCellArray();
-}
-
-void PuzzleBoard::drawBoard() {
-    cellsInfo = getCellsInfoFromCellArray();
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            cellArray[r][c].draw();
-        }
-    }
-}
-
-bool PuzzleBoard::solve(bool useBruteForce) {
-    clearBoard();
-    giveMetaKnowledgeToCells();
-    writeNotesFromIntersections();
-    removeNotesFixedValues();
-
-    bool solved;
-    //Do as much as we can with logic
-    solved = logicSolve(false);
-
-    //Smart bruteforce
-    if (!solved && useBruteForce) {
-        solved |= smartBruteForceSolve();
-    }
-
-    cellsInfo = getCellsInfoFromCellArray();
-    drawBoard();
-
-    return solved;
-}
-
-bool PuzzleBoard::logicSolve(bool lazy) {
-    if (!hasEmptyCells()) {
-        return checkSolved();
-    }
-
-    // do {
-    do {
-        do {
-            do {
-                do {
-                    do {
-                        do {
-                            do {
-                            } while (writeCellsWithOneNoteAndRemoveDupNotes());
-                        } while (adjustNotesByLogicalRange());
-                    } while (updateClueCellCombos());
-                } while (solveUniquesWithOneEmpty());
-            } while (!lazy && solveCellsWithNecessaryValue());
-        } while (!lazy && removeExtraNotesFromUniques());
-    } while (!lazy && removeNotesNotInPossibleCombos());
-    //} while (removeNotesNotInPossiblePerms());
-
-    return checkSolved();
-}
-
-
-bool PuzzleBoard::smartBruteForceSolve() {
-    if (!hasEmptyCells()) {
-        return checkSolved();
-    }
-
-    CellPos cell;
-    cell.row = -1;
-    cell.col = -1;
-
-    //Pick empty nonclue cell with lowest number of notes
-    int noteCount, minNotes = 10;
-    bool lowest = false;
-    for (int r = 0; r < rows; r++) {
-        if (lowest) break;
-        for (int c = 0; c < cols; c++) {
-            if (lowest) break;
-            if (cellArray[r][c].getType() == CLUE)
-                continue;
-            if (cellArray[r][c].getValue() != 0)
-                continue;
-
-            noteCount = 0;
-            for (int i = 1; i < 10; i++) {
-                if (cellArray[r][c].getNote(i)) {
-                    noteCount++;
-                    if (noteCount > minNotes)
-                        break;
-                }
-            }
-            if (noteCount < minNotes) {
-                minNotes = noteCount;
-                //Save the cell
-                cell.row = r;
-                cell.col = c;
-                //Can't get a lower number of notes, so stop
-                if (minNotes == 0) {
-                    lowest = true;
-                    return false;
-                }
-            }
-        }
-    }
-
-    //Save board state
-    QVector<CellInfo> savedCellInfo = getCellsInfoFromCellArray();
-
-    //Loop through the notes of the cell we picked
-    for (int i = 1; i < 10; i++) {
-        if (!cellArray[cell.row][cell.col].getNote(i))
-            continue;
-
-        //Try a note on the cell we picked
-        setCellValueAndEraseNeighborNoteDups(cell, i);
-
-        //Attempt to solve
-        bool solved = false;
-        solved |= logicSolve(true);
-        solved |= smartBruteForceSolve();
-        if (solved) return true;
-
-        //Undo the previous brute force, since it didn't work
-        updateCellArray(savedCellInfo);
-    }
-
-    return false;
-}
-
-bool PuzzleBoard::removeNotesNotInPossiblePerms() {
-    bool changed = false;
-
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == NONCLUE)
-                continue;
-            if (cellArray[r][c].getRightClue() == 0 &&
-                    cellArray[r][c].getDownClue() == 0)
-                continue;
-
-            //Right clue
-            if (cellArray[r][c].getRightClue()) {
-                //Get the notes of all cells in this right group
-                QVector<QVector<int>> cellsNotes;
-                for (int c3 = c+1; c3 < cols; c3++) {
-                    if (cellArray[r][c3].getType() == CLUE)
-                        break;
-                    cellsNotes.push_back(QVector<int>());
-                    if (cellArray[r][c3].getFixed()) {
-                        cellsNotes[cellsNotes.size()-1].push_back(cellArray[r][c3].getValue());
-                    }
-                    else {
-                        for (int n = 0; n < 10; n++) {
-                            if (cellArray[r][c3].getNote(n))
-                                cellsNotes[c3 - (c+1)].push_back(n);
-                        }
-                    }
-                }
-
-                //For every unsolved cell in this right clue
-                for (int c2 = c+1; c2 < cols; c2++) {
-                    if (cellArray[r][c2].getType() == CLUE)
-                        break;
-                    if (cellArray[r][c2].getValue())
-                        continue;
-
-                    //Put all other cells notes in otherCellsNotes
-                    QVector<QVector<int>> otherCellsNotes = cellsNotes;
-                    otherCellsNotes.erase(otherCellsNotes.begin() + c2 - (c+1));
-
-                    //For each of this cells notes
-                    for (int n = 1; n < 10; n++) {
-                        if (!cellArray[r][c2].getNote(n))
-                            continue;
-
-                        //Iterators for the current note we're using from each cell
-                        QVector<QVector<int>::const_iterator> currNoteItr;
-                        //Start them all off on the first note
-                        for (int i = 0; i < int(otherCellsNotes.size()); i++) {
-                            currNoteItr.push_back(otherCellsNotes[i].begin());
-                        }
-
-                        //Try every single perm of this note + other cells notes
-                        bool noteIsInAPerm = false;
-                        while (currNoteItr[0] != otherCellsNotes[0].end()) {
-                            //Make sure there are no dup numbers being used
-                            bool repeatedNumber = false;
-                            QVector<int> notesBeingUsed(1, n);
-                            for (int i = 0; i < int(currNoteItr.size()); i++) {
-                                notesBeingUsed.push_back(*currNoteItr[i]);
-                            }
-                            for (int i = 0; i < int(notesBeingUsed.size()); i++) {
-                                if (repeatedNumber) break;
-                                for (int j = 0; j < int(notesBeingUsed.size()); j++) {
-                                    if (i == j) continue;
-                                    if (notesBeingUsed[i] == notesBeingUsed[j]) {
-                                        repeatedNumber = true;
-                                        break;
-                                    }
-                                }
-                            }
-
-                            if (!repeatedNumber) {
-                                //Get the sum of all the notes being tested
-                                int sum = n;
-                                for (int i = 0; i < int(currNoteItr.size()); i++) {
-                                    sum += *currNoteItr[i];
-                                }
-
-                                if (sum == cellArray[r][c].getRightClue()) {
-                                    noteIsInAPerm = true;
-                                    break;
-                                }
-                            }
-
-                            //Update iterators to the next perm
-                            //Update last iterator (cell) to next note
-                            currNoteItr.last()++;
-                            //If we finished this cells notes, go back to this cells
-                            //first note and move the previous cell to the next note
-                            int cellIndex = otherCellsNotes.size()-1;
-                            while (currNoteItr[cellIndex] == otherCellsNotes[cellIndex].end()) {
-                                //If we've reached the last note on the very first cell, we're done
-                                if (cellIndex == 0) {
-                                    break;
-                                }
-                                currNoteItr[cellIndex] = otherCellsNotes[cellIndex].begin();
-                                cellIndex--;
-                                currNoteItr[cellIndex]++;
-                            }
-
-                        }
-
-                        if (!noteIsInAPerm) {
-                            cellArray[r][c2].setNote(n, false);
-                            changed = true;
-                        }
-
-                    }
-                }
-            }
-
-            //Down clue
-            if (cellArray[r][c].getDownClue()) {
-                //Get the notes of all cells in this right group
-                QVector<QVector<int>> cellsNotes;
-                for (int r3 = r+1; r3 < rows; r3++) {
-                    if (cellArray[r3][c].getType() == CLUE)
-                        break;
-                    cellsNotes.push_back(QVector<int>());
-                    if (cellArray[r3][c].getFixed()) {
-                        cellsNotes[cellsNotes.size()-1].push_back(cellArray[r3][c].getValue());
-                    }
-                    else {
-                        for (int n = 0; n < 10; n++) {
-                            if (cellArray[r3][c].getNote(n))
-                                cellsNotes[r3 - (r+1)].push_back(n);
-                        }
-                    }
-                }
-
-                //For every unsolved cell in this right clue
-                for (int r2 = r+1; r2 < rows; r2++) {
-                    if (cellArray[r2][c].getType() == CLUE)
-                        break;
-                    if (cellArray[r2][c].getValue())
-                        continue;
-
-                    //Put all other cells notes in otherCellsNotes
-                    QVector<QVector<int>> otherCellsNotes = cellsNotes;
-                    otherCellsNotes.erase(otherCellsNotes.begin() + r2 - (r+1));
-
-                    //For each of this cells notes
-                    for (int n = 1; n < 10; n++) {
-                        if (!cellArray[r2][c].getNote(n))
-                            continue;
-
-                        //Iterators for the current note we're using from each cell
-                        QVector<QVector<int>::const_iterator> currNoteItr;
-                        //Start them all off on the first note
-                        for (int i = 0; i < int(otherCellsNotes.size()); i++) {
-                            currNoteItr.push_back(otherCellsNotes[i].begin());
-                        }
-
-                        //Try every single perm of this note + other cells notes
-                        bool noteIsInAPerm = false;
-                        while (currNoteItr[0] != otherCellsNotes[0].end()) {
-                            //Make sure there are no dup numbers being used
-                            bool repeatedNumber = false;
-                            QVector<int> notesBeingUsed(1, n);
-                            for (int i = 0; i < int(currNoteItr.size()); i++) {
-                                notesBeingUsed.push_back(*currNoteItr[i]);
-                            }
-                            for (int i = 0; i < int(notesBeingUsed.size()); i++) {
-                                if (repeatedNumber) break;
-                                for (int j = 0; j < int(notesBeingUsed.size()); j++) {
-                                    if (i == j) continue;
-                                    if (notesBeingUsed[i] == notesBeingUsed[j]) {
-                                        repeatedNumber = true;
-                                        break;
-                                    }
-                                }
-                            }
-
-                            if (!repeatedNumber) {
-                                //Get the sum of all the notes being tested
-                                int sum = n;
-                                for (int i = 0; i < int(currNoteItr.size()); i++) {
-                                    sum += *currNoteItr[i];
-                                }
-
-                                if (sum == cellArray[r][c].getDownClue()) {
-                                    noteIsInAPerm = true;
-                                    break;
-                                }
-                            }
-
-                            //Update iterators to the next perm
-                            //Update last iterator (cell) to next note
-                            currNoteItr.last()++;
-                            //If we finished this cells notes, go back to this cells
-                            //first note and move the previous cell to the next note
-                            int cellIndex = otherCellsNotes.size()-1;
-                            while (currNoteItr[cellIndex] == otherCellsNotes[cellIndex].end()) {
-                                //If we've reached the last note on the very first cell, we're done
-                                if (cellIndex == 0) {
-                                    break;
-                                }
-                                currNoteItr[cellIndex] = otherCellsNotes[cellIndex].begin();
-                                cellIndex--;
-                                currNoteItr[cellIndex]++;
-                            }
-
-                        }
-
-                        if (!noteIsInAPerm) {
-                            cellArray[r2][c].setNote(n, false);
-                            changed = true;
-                        }
-
-                    }
-                }
-            }
-
-        }
-    }
-
-    return changed;
-}
-
-bool PuzzleBoard::updateClueCellCombos() {
-    bool changed = false;
-
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == NONCLUE)
-                continue;
-            if (cellArray[r][c].getRightClue() == 0 &&
-                    cellArray[r][c].getDownClue() == 0)
-                continue;
-
-            QVector<QVector<int>> rCombos = cellArray[r][c].getRightCombos();
-            QVector<QVector<int>> dCombos = cellArray[r][c].getDownCombos();
-
-            //If a cell in this group is solved,
-            //delete the combos that don't include the solved number
-            //Right clue
-            for (int c2 = c+1; c2 < cols; c2++) {
-                if (cellArray[r][c2].getType() == CLUE)
-                    break;
-                int v = cellArray[r][c2].getValue();
-                if (v == 0) continue;
-                for (int i = 0; i < int(rCombos.size()); i++) {
-                    bool found = false;
-                    for (int j = 0; j < int(rCombos[i].size()); j++) {
-                        if (rCombos[i][j] == v) {
-                            found = true;
-                            break;
-                        }
-                        if (rCombos[i][j] > v) {
-                            break;
-                        }
-                    }
-                    if (!found) {
-                        rCombos.erase(rCombos.begin()+i);
-                        i--;
-                        changed = true;
-                    }
-                }
-            }
-            //Down clue
-            for (int r2 = r+1; r2 < rows; r2++) {
-                if (cellArray[r2][c].getType() == CLUE)
-                    break;
-                int v = cellArray[r2][c].getValue();
-                if (v == 0) continue;
-                for (int i = 0; i < int(dCombos.size()); i++) {
-                    bool found = false;
-                    for (int j = 0; j < int(dCombos[i].size()); j++) {
-                        if (dCombos[i][j] == v) {
-                            found = true;
-                            break;
-                        }
-                        if (dCombos[i][j] > v) {
-                            break;
-                        }
-                    }
-                    if (!found) {
-                        dCombos.erase(dCombos.begin()+i);
-                        i--;
-                        changed = true;
-                    }
-                }
-            }
-
-            //Delete combos that don't contain any of the cells notes
-            //Right clue
-            for (int c2 = c+1; c2 < cols; c2++) {
-                if (cellArray[r][c2].getType() == CLUE)
-                    break;
-                if (cellArray[r][c2].getValue())
-                    continue;
-
-                //Get all of the notes for this cell
-                QVector<int> cellsNotes;
-                for (int i = 1; i < 10; i++) {
-                    if (cellArray[r][c2].getNote(i)) {
-                        cellsNotes.push_back(i);
-                    }
-                }
-
-                //If the combo doesn't have any of this cells notes,
-                //it's not possible, so remove it
-                bool hasAnyOfCellsNotes = false;
-                //For all combos,
-                for (int i = 0; i < int(rCombos.size()); i++) {
-                    //Check that at least one note is in the current combo
-                    hasAnyOfCellsNotes = false;
-                    for (int n = 0; n < int(cellsNotes.size()); n++) {
-                        //For all numbers in the combo..
-                        for (int j = 0; j < int(rCombos[i].size()); j++) {
-                            //it has this note
-                            if (rCombos[i][j] == cellsNotes[n]) {
-                                hasAnyOfCellsNotes = true;
-                                break;
-                            }
-                            //it didn't have this note
-                            if (rCombos[i][j] > cellsNotes[n])
-                                break;
-                        }
-                        if (hasAnyOfCellsNotes) break;
-                    }
-                    //If not, delete the combo
-                    if (!hasAnyOfCellsNotes) {
-                        rCombos.erase(rCombos.begin()+i);
-                        i--;
-                        changed = true;
-                    }
-                }
-            }
-            //Down  clue
-            for (int r2 = r+1; r2 < rows; r2++) {
-                if (cellArray[r2][c].getType() == CLUE)
-                    break;
-                if (cellArray[r2][c].getValue())
-                    continue;
-
-                //Get all of the notes for this cell
-                QVector<int> cellsNotes;
-                for (int i = 1; i < 10; i++) {
-                    if (cellArray[r2][c].getNote(i)) {
-                        cellsNotes.push_back(i);
-                    }
-                }
-
-                //If the combo doesn't have any of this cells notes,
-                //it's not possible, so remove it
-                bool hasAnyOfCellsNotes = false;
-                //For all combos,
-                for (int i = 0; i < int(dCombos.size()); i++) {
-                    //Check that at least one note is in the current combo
-                    hasAnyOfCellsNotes = false;
-                    for (int n = 0; n < int(cellsNotes.size()); n++) {
-                        //For all numbers in the combo..
-                        for (int j = 0; j < int(dCombos[i].size()); j++) {
-                            //it has this note
-                            if (dCombos[i][j] == cellsNotes[n]) {
-                                hasAnyOfCellsNotes = true;
-                                break;
-                            }
-                            //it didn't have this note
-                            if (dCombos[i][j] > cellsNotes[n])
-                                break;
-                        }
-                        if (hasAnyOfCellsNotes) break;
-                    }
-                    //If not, delete the combo
-                    if (!hasAnyOfCellsNotes) {
-                        dCombos.erase(dCombos.begin()+i);
-                        i--;
-                        changed = true;
-                    }
-                }
-            }
-
-            //Set combos
-            cellArray[r][c].setRightCombos(rCombos);
-            cellArray[r][c].setDownCombos(dCombos);
-
-        }
-    }
-
-    return changed;
-}
-
-bool PuzzleBoard::solveUniquesWithOneEmpty() {
-    bool changed = false;
-
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == NONCLUE)
-                continue;
-            if (cellArray[r][c].getDownClue() == 0 &&
-                    cellArray[r][c].getRightClue() == 0)
-                continue;
-
-            //Down
-            QVector<QVector<int>> dCombos = cellArray[r][c].getDownCombos();
-            //Is there only one combo to solve this clue?
-            if (dCombos.size() == 1) {
-                //Get all the nums we need
-                QVector<int> numsLeft = dCombos[0];
-
-                CellPos unsolvedCell = { -1, -1 };
-                for (int r2 = r+1; r2 < rows; r2++) {
-                    if (cellArray[r2][c].getType() == CLUE)
-                        break;
-                    int v = cellArray[r2][c].getValue();
-                    //Solved nonclue
-                    if (v) {
-                        //Remove this num from our list
-                        int index = numsLeft.indexOf(v);
-                        if (index > -1) {
-                            numsLeft.erase(numsLeft.begin()+index);
-                        }
-                    }
-                    else {
-                        //Break on second empty cell
-                        if (unsolvedCell.row != -1 ||
-                                unsolvedCell.col != -1)
-                            break;
-                        //Save location of empty cell
-                        unsolvedCell = { r2, c };
-                    }
-                }
-
-                //Set if there was only a single empty cell
-                if (numsLeft.size() == 1 && unsolvedCell.row != -1 && unsolvedCell.col != -1) {
-                    setCellValueAndEraseNeighborNoteDups(unsolvedCell, numsLeft[0]);
-                    changed = true;
-                }
-            }
-
-            //Right
-            QVector<QVector<int>> rCombos = cellArray[r][c].getRightCombos();
-            //Is there only one combo to solve this clue?
-            if (rCombos.size() == 1) {
-                //Get all the nums we need
-                QVector<int> numsLeft = rCombos[0];
-
-                CellPos unsolvedCell = { -1, -1 };
-                for (int c2 = c+1; c2 < cols; c2++) {
-                    if (cellArray[r][c2].getType() == CLUE)
-                        break;
-                    int v = cellArray[r][c2].getValue();
-                    //Solved nonclue
-                    if (v) {
-                        //Remove this num from our list
-                        int index = numsLeft.indexOf(v);
-                        if (index > -1) {
-                            numsLeft.erase(numsLeft.begin()+index);
-                        }
-                    }
-                    else {
-                        //Break on second empty cell
-                        if (unsolvedCell.row != -1 ||
-                                unsolvedCell.col != -1)
-                            break;
-                        //Save location of empty cell
-                        unsolvedCell = { r, c2 };
-                    }
-                }
-
-                //Set if there was only a single empty cell
-                if (numsLeft.size() == 1 && unsolvedCell.row != -1 && unsolvedCell.col != -1) {
-                    setCellValueAndEraseNeighborNoteDups(unsolvedCell, numsLeft[0]);
-                    changed = true;
-                }
-            }
-
-
-        }
-    }
-
-    return changed;
-}
-
-bool PuzzleBoard::solveCellsWithNecessaryValue() {
-    bool changed = false;
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == NONCLUE)
-                continue;
-            if (cellArray[r][c].getDownClue() == 0 &&
-                    cellArray[r][c].getRightClue() == 0)
-                continue;
-
-            QVector<bool> necessary(10, true);
-            int timesSeen[10];
-            CellPos cell[10];
-
-            //Right clue
-            if (cellArray[r][c].getRightClue()) {
-                QVector<QVector<int>> rCombos = cellArray[r][c].getRightCombos();
-
-                //Figure out which numbers are in every combo
-                //For every number,
-                for (int n = 1; n < 10; n++) {
-                    //look in every combo,
-                    bool found = false;
-                    for (int i = 0; i < int(rCombos.size()); i++) {
-                        found = false;
-                        //and check to make sure the number is in the combo
-                        for (int j = 0; j < int(rCombos[i].size()); j++) {
-                            if (rCombos[i][j] == n) {
-                                found = true;
-                                break;
-                            }
-                            if (rCombos[i][j] > n) {
-                                break;
-                            }
-                        }
-                        //If it wasn't in a combo, it's not necessary
-                        if (!found) {
-                            necessary[n] = false;
-                        }
-                    }
-                }
-
-                //Set cells that are the only ones with necessary values
-                bool hasAnyNecessaries = false;
-                for (int n = 1; n < 10; n++) {
-                    if (necessary[n]) {
-                        hasAnyNecessaries = true;
-                        break;
-                    }
-                }
-                if (hasAnyNecessaries) {
-                    //Count occurences of each note
-                    for (int i = 0; i < 10; i++) {
-                        timesSeen[i] = 0;
-                    }
-                    for (int c2 = c+1; c2 < cols; c2++) {
-                        if (cellArray[r][c2].getType() == CLUE)
-                            break;
-
-                        int v = cellArray[r][c2].getValue();
-
-                        if (v == 0) {
-                            for (int i = 1; i < 10; i++) {
-                                if (cellArray[r][c2].getNote(i)) {
-                                    timesSeen[i]++;
-                                    if (timesSeen[i] == 1) {
-                                        cell[i] = { r, c2 };
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    //Set necessary vales
-                    for (int i = 1; i < 10; i++) {
-                        if (timesSeen[i] == 1 &&
-                                necessary[i] == true) {
-                            setCellValueAndEraseNeighborNoteDups(cell[i], i);
-                            changed = true;
-                        }
-                    }
-                }
-            }
-
-            //Down clue
-            if (cellArray[r][c].getDownClue()) {
-                QVector<QVector<int>> dCombos = cellArray[r][c].getDownCombos();
-                for (int i = 0; i < 10; i++) {
-                    necessary[i] = true;
-                    cell[i] = { -1, -1 };
-                }
-                //Figure out which numbers are in every combo
-                //For every number,
-                for (int n = 1; n < 10; n++) {
-                    //look in every combo,
-                    bool found = false;
-                    for (int i = 0; i < int(dCombos.size()); i++) {
-                        found = false;
-                        //and check to make sure the number is in the combo
-                        for (int j = 0; j < int(dCombos[i].size()); j++) {
-                            if (dCombos[i][j] == n) {
-                                found = true;
-                                break;
-                            }
-                            if (dCombos[i][j] > n) {
-                                break;
-                            }
-                        }
-                        //If it wasn't in a combo, it's not necessary
-                        if (!found) {
-                            necessary[n] = false;
-                        }
-                    }
-                }
-
-                //Set cells that are the only ones with necessary values
-                bool hasAnyNecessaries = false;
-                for (int n = 1; n < 10; n++) {
-                    if (necessary[n]) {
-                        hasAnyNecessaries = true;
-                        break;
-                    }
-                }
-                if (hasAnyNecessaries) {
-                    //Count occurences of each note
-                    for (int i = 0; i < 10; i++) {
-                        timesSeen[i] = 0;
-                    }
-                    for (int r2 = r+1; r2 < rows; r2++) {
-                        if (cellArray[r2][c].getType() == CLUE)
-                            break;
-
-                        int v = cellArray[r2][c].getValue();
-                        if (v == 0) {
-                            for (int i = 1; i < 10; i++) {
-                                if (cellArray[r2][c].getNote(i)) {
-                                    timesSeen[i]++;
-                                    if (timesSeen[i] == 1) {
-                                        cell[i] = { r2, c };
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    //Set necessary vales
-                    for (int i = 1; i < 10; i++) {
-                        if (timesSeen[i] == 1 &&
-                                necessary[i] == true) {
-                            setCellValueAndEraseNeighborNoteDups(cell[i], i);
-                            changed = true;
-                        }
-                    }
-                }
-            }
-
-        }
-    }
-
-    return changed;
-}
-
-bool PuzzleBoard::adjustNotesByLogicalRange() {
-    bool changed = false;
-
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == NONCLUE)
-                continue;
-            if (cellArray[r][c].getDownClue() == 0
-                    && cellArray[r][c].getRightClue() == 0)
-                continue;
-
-            //For every unsolved nonclue cell this clue cell has,
-            //remove all notes less than
-            //the clue - (sum of its row/col neighbors max notes),
-            //and all notes higher than
-            //the clue - (sum of its row/col neighbors min notes)
-
-            //Row / right clue
-            //Get min and max notes for each cell
-            int maxNoteSum = 0, minNoteSum = 0;
-            QVector<int> minNotes, maxNotes;
-            int cellMin, cellMax;
-
-            if (cellArray[r][c].getRightClue()) {
-                for (int c2 = c+1; c2 < cols; c2++) {
-                    if (cellArray[r][c2].getType() == CLUE)
-                        break;
-                    minNotes.push_back(getMinNoteForCell({r, c2}));
-                    maxNotes.push_back(getMaxNoteForCell({r, c2}));
-                }
-                for (int i = 0; i < int(minNotes.size()); i++) {
-                    minNoteSum += minNotes[i];
-                }
-                for (int i = 0; i < int(maxNotes.size()); i++) {
-                    maxNoteSum += maxNotes[i];
-                }
-
-                //For each unsolved cell (for right clue),
-                //delete the notes not in the logical range
-                for (int c2 = c+1; c2 < cols; c2++) {
-                    if (cellArray[r][c2].getType() == CLUE)
-                        break;
-                    if (cellArray[r][c2].getValue())
-                        continue;
-                    cellMin = cellArray[r][c].getRightClue()
-                            - (maxNoteSum - maxNotes[c2 - (c+1)]);
-                    cellMax = cellArray[r][c].getRightClue()
-                            - (minNoteSum - minNotes[c2 - (c+1)]);
-
-                    //Remove the notes too low
-                    for (int i = cellMin-1; i > 0; i--) {
-                        if (i > 9) i = 9;
-                        if (cellArray[r][c2].getNote(i)) {
-                            cellArray[r][c2].setNote(i, false);
-                            changed = true;
-                        }
-                    }
-                    //Remove the notes too high
-                    for (int i = cellMax+1; i < 10; i++) {
-                        if (i < 1) i = 1;
-                        if (cellArray[r][c2].getNote(i)) {
-                            cellArray[r][c2].setNote(i, false);
-                            changed = true;
-                        }
-                    }
-                }
-
-            }
-
-            if (cellArray[r][c].getDownClue()) {
-                //Column / down clue
-                //Get min and max notes for each cell
-                maxNoteSum = minNoteSum = 0;
-                minNotes.clear();
-                maxNotes.clear();
-                for (int r2 = r+1; r2 < rows; r2++) {
-                    if (cellArray[r2][c].getType() == CLUE)
-                        break;
-                    minNotes.push_back(getMinNoteForCell({r2, c}));
-                    maxNotes.push_back(getMaxNoteForCell({r2, c}));
-                }
-                for (int i = 0; i < int(minNotes.size()); i++) {
-                    minNoteSum += minNotes[i];
-                }
-                for (int i = 0; i < int(maxNotes.size()); i++) {
-                    maxNoteSum += maxNotes[i];
-                }
-
-                //For each unsolved cell (for down clue),
-                //delete the notes not in the logical range
-                for (int r2 = r+1; r2 < rows; r2++) {
-                    if (cellArray[r2][c].getType() == CLUE)
-                        break;
-                    if (cellArray[r2][c].getValue())
-                        continue;
-                    cellMin = cellArray[r][c].getDownClue()
-                            - (maxNoteSum - maxNotes[r2 - (r+1)]);
-                    cellMax = cellArray[r][c].getDownClue()
-                            - (minNoteSum - minNotes[r2 - (r+1)]);
-
-                    //Remove the notes too low
-                    for (int i = cellMin-1; i > 0; i--) {
-                        if (i > 9) i = 9;
-                        if (cellArray[r2][c].getNote(i)) {
-                            cellArray[r2][c].setNote(i, false);
-                            changed = true;
-                        }
-                    }
-                    //Remove the notes too high
-                    for (int i = cellMax+1; i < 10; i++) {
-                        if (i < 1) i = 1;
-                        if (cellArray[r2][c].getNote(i)) {
-                            cellArray[r2][c].setNote(i, false);
-                            changed = true;
-                        }
-                    }
-                }
-            }
-
-
-        }
-    }
-
-    return changed;
-}
-
-bool PuzzleBoard::removeExtraNotesFromUniques() {
-    bool changed = false;
-
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == NONCLUE)
-                continue;
-            if (cellArray[r][c].getDownClue() == 0 &&
-                    cellArray[r][c].getRightClue() == 0)
-                continue;
-
-            QVector<QVector<int>> cellNotes;
-
-            //Right clue
-            QVector<QVector<int>> rCombos = cellArray[r][c].getRightCombos();
-            //Is there only one possible combo?
-            if (rCombos.size() == 1) {
-                //Get all of the notes for every cell
-                for (int c2 = c + 1; c2 < cols; c2++) {
-                    if (cellArray[r][c2].getType() == CLUE)
-                        break;
-                    cellNotes.push_back(QVector<int>());
-                    for (int i = 1; i < 10; i++) {
-                        if (cellArray[r][c2].getNote(i)) {
-                            cellNotes[c2 - (c+1)].push_back(i);
-                        }
-                    }
-                }
-
-                //If there was ever a case where there were N
-                //cells with ONLY the same N notes, we can safely
-                //remove those notes from other cells
-                int count = 0;
-                for (int i = 0; i < int(cellNotes.size()); i++) {
-                    count = 0;
-                    //Count times these notes match another cells notes
-                    for (int j = 0; j < int(cellNotes.size()); j++) {
-                        if (cellNotes[i] == cellNotes[j]) {
-                            count++;
-                        }
-                    }
-                    //If there were the same number of matching cells
-                    //as there are notes on the cells
-                    if (count > 1 && count == int(cellNotes[i].size())) {
-                        //Remove those notes from other cells
-                        for (int c2 = c + 1; c2 < cols; c2++) {
-                            if (cellArray[r][c2].getType() == CLUE)
-                                break;
-                            if (cellNotes[c2 - (c+1)] != cellNotes[i]) {
-                                for (int n = 0; n < int(cellNotes[i].size()); n++) {
-                                    if (cellArray[r][c2].getNote(cellNotes[i][n])) {
-                                        cellArray[r][c2].setNote(cellNotes[i][n], false);
-                                        changed = true;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-            //Down clue
-
-            QVector<QVector<int>> dCombos = cellArray[r][c].getDownCombos();
-            //Is there only one possible combo?
-            if (dCombos.size() == 1) {
-                cellNotes.clear();
-                //Down clue
-                //Get all of the notes for every cell
-                for (int r2 = r + 1; r2 < rows; r2++) {
-                    if (cellArray[r2][c].getType() == CLUE)
-                        break;
-                    cellNotes.push_back(QVector<int>());
-                    for (int i = 1; i < 10; i++) {
-                        if (cellArray[r2][c].getNote(i)) {
-                            cellNotes[r2 - (r+1)].push_back(i);
-                        }
-                    }
-                }
-
-                //If there was ever a case where there were N
-                //cells with ONLY the same N notes, we can safely
-                //remove those notes from other cells
-                int count = 0;
-                for (int i = 0; i < int(cellNotes.size()); i++) {
-                    count = 0;
-                    //Count times these notes match another cells notes
-                    for (int j = 0; j < int(cellNotes.size()); j++) {
-                        if (cellNotes[i] == cellNotes[j]) {
-                            count++;
-                        }
-                    }
-                    //If there were the same number of matching cells
-                    //as there are notes on the cells
-                    if (count > 1 && count == int(cellNotes[i].size())) {
-                        //Remove those notes from other cells
-                        for (int r2 = r + 1; r2 < rows; r2++) {
-                            if (cellArray[r2][c].getType() == CLUE)
-                                break;
-                            if (cellNotes[r2 - (r+1)] != cellNotes[i]) {
-                                for (int n = 0; n < int(cellNotes[i].size()); n++) {
-                                    if (cellArray[r2][c].getNote(cellNotes[i][n])) {
-                                        cellArray[r2][c].setNote(cellNotes[i][n], false);
-                                        changed = true;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-
-        }
-    }
-
-    return changed;
-}
-
-void PuzzleBoard::removeNotesFixedValues() {
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == CLUE)
-                continue;
-            if (cellArray[r][c].getFixed()) {
-                setCellValueAndEraseNeighborNoteDups({ r, c }, cellArray[r][c].getValue());
-            }
-        }
-    }
-}
-
-void PuzzleBoard::putBackFixedValues() {
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == CLUE)
-                continue;
-            if (cellArray[r][c].getFixed()) {
-                for (int n = 1; n < 10; n++) {
-                    cellArray[r][c].setNote(n, false);
-                }
-            }
-
-        }
-    }
-}
-
-bool PuzzleBoard::removeNotesNotInPossibleCombos() {
-    bool changed = false;
-
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == NONCLUE)
-                continue;
-            if (cellArray[r][c].getRightClue() == 0 &&
-                    cellArray[r][c].getDownClue() == 0)
-                continue;
-
-            QVector<QVector<int>> rCombos = cellArray[r][c].getRightCombos();
-            QVector<QVector<int>> dCombos = cellArray[r][c].getDownCombos();
+                s += QString::number(dClue) + "/" +
+                        QString::number(rClue) + " ";
+            }
+            else {
+                s += "- ";
+            }
+        }
+        else if (info[i].type == NONCLUE) {
+            v = info[i].valueOrClues[0];
+            s += QString::number(v);
 
-            //Right clue
-            //For this clue cells row
-            for (int c2 = c+1; c2 < cols; c2++) {
-                if (cellArray[r][c2].getType() == CLUE)
+            //Does it have any notes?
+            bool hasAnyNotes = false;
+            for (int n = 1; n < 10; n++) {
+                if (info[i].notes[n]) {
+                    hasAnyNotes = true;
                     break;
-                if (cellArray[r][c2].getValue())
-                    continue;
-                //For every note in this unsolved cell,
-                for (int n = 1; n < 10; n++) {
-                    if (!cellArray[r][c2].getNote(n))
-                        continue;
-                    //If the note isn't in any of the possible combos, remove it
-                    bool foundInAnyCombo = false;
-                    for (int i = 0; i < int(rCombos.size()); i++) {
-                        bool found = false;
-                        for (int j = 0; j < int(rCombos[i].size()); j++) {
-                            if (rCombos[i][j] == n) {
-                                found = true;
-                                break;
-                            }
-                            if (rCombos[i][j] > n) {
-                                break;
-                            }
-                        }
-                        if (found) {
-                            foundInAnyCombo = true;
-                            break;
-                        }
-                    }
-                    if (!foundInAnyCombo) {
-                        cellArray[r][c2].setNote(n, false);
-                        changed = true;
-                    }
                 }
             }
 
-            //Down clue
-            //For this clue cells col
-            for (int r2 = r+1; r2 < rows; r2++) {
-                if (cellArray[r2][c].getType() == CLUE)
-                    break;
-                if (cellArray[r2][c].getValue())
-                    continue;
-                //For every note in this unsolved cell,
+            if (hasAnyNotes) {
+                s += 'n';
+                //Add each noted number
                 for (int n = 1; n < 10; n++) {
-                    if (!cellArray[r2][c].getNote(n))
-                        continue;
-                    //If the note isn't in any of the possible combos, remove it
-                    bool foundInAnyCombo = false;
-                    for (int i = 0; i < int(dCombos.size()); i++) {
-                        bool found = false;
-                        for (int j = 0; j < int(dCombos[i].size()); j++) {
-                            if (dCombos[i][j] == n) {
-                                found = true;
-                                break;
-                            }
-                            if (dCombos[i][j] > n) {
-                                break;
-                            }
-                        }
-                        if (found) {
-                            foundInAnyCombo = true;
-                            break;
-                        }
-                    }
-                    if (!foundInAnyCombo) {
-                        cellArray[r2][c].setNote(n, false);
-                        changed = true;
-                    }
+                    if (info[i].notes[n])
+                        s += QString::number(n);
                 }
             }
+            else if (info[i].fixed) {
+                s += 'f';
+            }
 
-
-            cellArray[r][c].setRightCombos(rCombos);
-            cellArray[r][c].setDownCombos(dCombos);
-
+            s += " ";
         }
     }
 
+    s += "t00:00:00";
 
-    return changed;
+    return s;
 }
 
-bool PuzzleBoard::writeNotesFromIntersections() {
-    bool changed = false;
+void PuzzleBoard::clearBoard() {
+    solveSteps.clear();
+    replayStep = 0;
+    history.clear();
 
-    bool* possNotes;
     for (int r = 0; r < rows; r++) {
         for (int c = 0; c < cols; c++) {
             if (cellArray[r][c].getType() == CLUE)
                 continue;
             if (cellArray[r][c].getFixed())
                 continue;
+            if (cellArray[r][c].getValue() || cellArray[r][c].getNoteMask())
+                markDirty({ r, c });
+            cellArray[r][c].setValue(0);
+            for (int i = 0; i < 10; i++)
+                cellArray[r][c].setNote(i, 0);
+        }
+    }
+    updateRunTracker();
+    cellsInfo = getCellsInfoFromCellArray();
+}
 
-            possNotes = getIntersectNotesForCell({r, c});
-
-            for (int i = 1; i < 10; i++) {
-                if (possNotes[i] != cellArray[r][c].getNote(i)) {
-                    changed = true;
-                }
-                cellArray[r][c].setNote(i, possNotes[i]);
-            }
+void PuzzleBoard::drawBoard() {
+    cellsInfo = getCellsInfoFromCellArray();
+    markAllDirty();
+}
 
-            delete [] possNotes;
+void PuzzleBoard::markDirty(CellPos pos) {
+    if (pos.row == -1 || pos.col == -1)
+        return;
 
-        }
-    }
+    //Qt collects the dirty rects into one paint event,
+    //and drops the parts that are scrolled out of view
+    update(cellArray[pos.row][pos.col].getRect());
+}
 
-    return changed;
+void PuzzleBoard::markAllDirty() {
+    update();
 }
 
-bool PuzzleBoard::writeCellsWithOneNoteAndRemoveDupNotes() {
-    bool changed = false;
-    int noteCount, val;
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == CLUE)
-                continue;
-            if (cellArray[r][c].getValue())
+void PuzzleBoard::paintEvent(QPaintEvent *event) {
+    //Only the cells that are in the region being painted
+    //(never more than what's on screen) are drawn
+    QRect rect = event->rect() & QRect(0, 0, cols*cellSize, rows*cellSize);
+    if (rect.isEmpty())
+        return;
+    int firstRow = rect.top()/cellSize, lastRow = rect.bottom()/cellSize;
+    int firstCol = rect.left()/cellSize, lastCol = rect.right()/cellSize;
+
+    QPainter painter(this);
+    for (int r = firstRow; r <= lastRow; r++) {
+        for (int c = firstCol; c <= lastCol; c++) {
+            QRect cellRect = cellArray[r][c].getRect();
+            if (!event->region().intersects(cellRect))
                 continue;
 
-            noteCount = 0;
-            for (int i = 1; i < 10; i++) {
-                if (cellArray[r][c].getNote(i)) {
-                    noteCount++;
-                    val = i;
-                    if (noteCount > 1)
-                        break;
-                }
-            }
-            //Only one note
-            if (noteCount == 1) {
-                //Set the cells value
-                setCellValueAndEraseNeighborNoteDups({r, c}, val);\
-                changed = true;
-            }
-
+            painter.save();
+            painter.setClipRect(cellRect);
+            painter.translate(cellRect.topLeft());
+            drawCell(painter, { r, c });
+            painter.restore();
         }
     }
-    return changed;
 }
 
-int PuzzleBoard::getMinNoteForCell(CellPos pos) const {
-    if (cellArray[pos.row][pos.col].getValue()) {
-        return cellArray[pos.row][pos.col].getValue();
+void PuzzleBoard::drawCell(QPainter &painter, CellPos pos) {
+    Cell *cellPtr = &cellArray[pos.row][pos.col];
+    bool dragging = draggingCell.row != -1 && draggingCell.col != -1;
+    bool isDragFrom = pos.row == draggingCell.row && pos.col == draggingCell.col;
+    bool isDragTo = pos.row == selectedCell.row && pos.col == selectedCell.col;
+
+    if (!dragging || (!isDragFrom && !isDragTo)) {
+        cellPtr->draw(painter);
     }
-    for (int i = 1; i < 10; i++) {
-        if (cellArray[pos.row][pos.col].getNote(i)) {
-            return i;
-        }
+    //Still over the cell it started on
+    else if (isDragFrom && isDragTo) {
+        cellPtr->draw(painter, DRAG_OPACITY);
     }
-    return 10;
-}
-
-int PuzzleBoard::getMaxNoteForCell(CellPos pos) const {
-    if (cellArray[pos.row][pos.col].getValue()) {
-        return cellArray[pos.row][pos.col].getValue();
+    //Over another cell: a 0 on dragFrom, and the drag value on dragTo
+    else if (isDragFrom && selectedCell.row != -1) {
+        cellPtr->drawNonClue(painter, 0, DRAG_OPACITY, 0.5);
     }
-    for (int i = 9; i > 0; i--) {
-        if (cellArray[pos.row][pos.col].getNote(i)) {
-            return i;
-        }
+    else if (isDragTo) {
+        cellPtr->drawNonClue(painter, cellArray[draggingCell.row][draggingCell.col].getValue(),
+                             DRAG_OPACITY, 0.5);
+    }
+    //Over a clue or fixed cell, so it's drawn at full opacity
+    else {
+        cellPtr->draw(painter);
     }
-    return 0;
 }
 
-bool* PuzzleBoard::getIntersectNotesForCell(CellPos pos) const {
-    Cell *cPtr = &cellArray[pos.row][pos.col];
-    bool *possible = new bool[10];
+bool PuzzleBoard::solve(bool useBruteForce) {
+    //The solver works on its own copy of the board
+    BoardModel model = getBoardModel();
+
+    //Without brute force, a cached solution might not
+    //be one logic finds. A trace only comes from solving.
+    //A board that can't be solved is solved anyway, so it's
+    //left with as much as logic got, cached or not
+    CanonicalForm form(model);
+    SolveStatus status;
+    if (useBruteForce && !traceEnabled &&
+            SolutionCache::get().lookup(form, model, status) && status == SOLVE_SOLVED) {
+        setFromBoardModel(model);
+        setSolveResults({ 0, 0, 0, 0, 0, 0 }, QVector<SolveTraceEntry>());
+        return true;
+    }
+
+    SolveLimits noLimits = { 0, 0 };
+    boardSolver.setLimits(noLimits);
+    boardSolver.setTraceEnabled(traceEnabled);
+    boardSolver.setStepLogEnabled(traceEnabled);
+    boardSolver.load(model);
+    bool solved = boardSolver.solve(useBruteForce);
+    boardSolver.store(model);
+    SolutionCache::get().insert(form, model, boardSolver.getStatus());
+
+    setFromBoardModel(model);
+    setSolveResults(boardSolver.getStats(), boardSolver.getTrace(), boardSolver.getSteps());
 
-    //Get possible down and right combos
-    QVector<QVector<int>> possDownCombos = sumInNumCombo[cPtr->getDownClue()][cPtr->getNumInDownSum()];
-    QVector<QVector<int>> possRightCombos = sumInNumCombo[cPtr->getRightClue()][cPtr->getNumInRightSum()];
+    return solved;
+}
 
-    bool possDownNums[10];
-    bool possRightNums[10];
-    for (int i = 0; i < 10; i++) {
-        possDownNums[i] = false;
-        possRightNums[i] = false;
-    }
+Fingerprint PuzzleBoard::getFingerprint() const {
+    return CanonicalForm(boardModel).getFingerprint();
+}
 
-    //If there was a down clue
-    if (cPtr->getDownClue() > 0) {
-        //Get possible down numbers
-        for (int i = 0; i < int(possDownCombos.size()); i++) {
-            for (int j = 0; j < int(possDownCombos[i].size()); j++) {
-                possDownNums[possDownCombos[i][j]] = true;
-            }
-        }
-    }
-    //If there wasn't a down clue
-    else {
-        //Set 1-9 to possible
-        for (int i = 1; i < 10; i++) {
-            possDownNums[i] = true;
+BoardModel PuzzleBoard::getBoardModel() const {
+    //The Solver ignores values and notes of nonfixed cells,
+    //and the clues and fixed cells only change on loading
+    return boardModel;
+}
+
+SolveStatus PuzzleBoard::checkSolvable(const SolveLimits &limits) {
+    CanonicalForm form(boardModel);
+    BoardModel model = boardModel;
+    SolveStatus status;
+    if (SolutionCache::get().lookup(form, model, status))
+        return status;
+
+    boardSolver.setLimits(limits);
+    boardSolver.setTraceEnabled(false);
+    boardSolver.setStepLogEnabled(false);
+    boardSolver.load(boardModel);
+    boardSolver.solve();
+    boardSolver.store(model);
+    SolutionCache::get().insert(form, model, boardSolver.getStatus());
+    return boardSolver.getStatus();
+}
+
+void PuzzleBoard::setFromBoardModel(const BoardModel &model) {
+    history.clear();
+    model.store(cellsInfo);
+    updateCellArray();
+    updateRunTracker();
+}
+
+SolveHint PuzzleBoard::getHint() {
+    //Same clues and fixed cells, with the player's numbers and notes
+    BoardModel model = boardModel;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            if (cellArray[r][c].getType() == CLUE || cellArray[r][c].getFixed())
+                continue;
+            int index = r*cols + c;
+            model.value[index] = quint8(cellArray[r][c].getValue());
+            model.mask[index] = cellArray[r][c].getNoteMask();
         }
     }
 
-    //If there was a right clue
-    if (cPtr->getRightClue() > 0) {
-        //Get possible right numbers
-        for (int i = 0; i < int(possRightCombos.size()); i++) {
-            for (int j = 0; j < int(possRightCombos[i].size()); j++) {
-                possRightNums[possRightCombos[i][j]] = true;
+    SolveHint hint = hintSolver.findHint(model);
+
+    //Point at a cell that's visibly wrong, if the solver couldn't
+    if (hint.rule == HINT_MISTAKE && hint.cell.row == -1) {
+        for (int i = 0; i < rows*cols && hint.cell.row == -1; i++) {
+            if (cellArray[i/cols][i%cols].getType() == NONCLUE && runTracker.hasConflict(i)) {
+                hint.cell = { i/cols, i%cols };
+                hint.digit = runTracker.getValue(i);
             }
         }
     }
-    //If there wasn't a right clue
-    else {
-        //Set 1-9 to possible
-        for (int i = 1; i < 10; i++) {
-            possRightNums[i] = true;
-        }
+    return hint;
+}
+
+void PuzzleBoard::setSolveResults(const SolveStats &stats, const QVector<SolveTraceEntry> &trace,
+                                  const QVector<SolveStep> &steps) {
+    solveStats = stats;
+    solveTrace = trace;
+    solveSteps = steps;
+    replayStep = solveSteps.size();
+}
+
+void PuzzleBoard::showSolveStep(int step) {
+    step = qBound(0, step, solveSteps.size());
+    if (step == replayStep)
+        return;
+    generation++;
+
+    //Walk the log from the step being shown, forwards
+    //or backwards, putting each change on its cell
+    while (replayStep != step) {
+        bool forward = replayStep < step;
+        const SolveStep &s = solveSteps[forward ? replayStep : replayStep-1];
+        int v = forward ? s.newValue : s.oldValue;
+        quint16 m = forward ? s.newMask : s.oldMask;
+
+        Cell &cell = cellArray[s.cell/cols][s.cell%cols];
+        cell.setValue(v);
+        cell.setNoteMask(v ? 0 : m);
+        markDirty({ s.cell/cols, s.cell%cols });
+
+        replayStep += forward ? 1 : -1;
     }
 
-    //Get the intersection of possible down and right numbers
-    for (int i = 0; i < 10; i++) {
-        possible[i] = possDownNums[i] & possRightNums[i];
+    //Back to where the solve ended, so the runs match the cells again
+    if (replayStep == solveSteps.size())
+        updateRunTracker();
+}
+
+bool PuzzleBoard::exportSolveTrace(const QString &fileName) const {
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
     }
-    return possible;
+
+    //JSON, with each guess as [depth, row, col, digit, outcome]
+    if (fileName.endsWith(".json", Qt::CaseInsensitive)) {
+        QJsonObject stats;
+        stats["nodes"] = solveStats.nodes;
+        stats["maxDepth"] = solveStats.maxDepth;
+        stats["backtracks"] = solveStats.backtracks;
+        stats["restoreNsecs"] = double(solveStats.restoreNsecs);
+        stats["memoHits"] = solveStats.memoHits;
+        stats["memoMisses"] = solveStats.memoMisses;
+
+        QJsonArray guesses;
+        for (int i = 0; i < int(solveTrace.size()); i++) {
+            QJsonArray guess;
+            guess.append(solveTrace[i].depth);
+            guess.append(solveTrace[i].cell.row);
+            guess.append(solveTrace[i].cell.col);
+            guess.append(solveTrace[i].digit);
+            guess.append(int(solveTrace[i].outcome));
+            guesses.append(guess);
+        }
+
+        QJsonObject root;
+        root["rows"] = rows;
+        root["cols"] = cols;
+        root["stats"] = stats;
+        root["guesses"] = guesses;
+        return file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) != -1;
+    }
+
+    //Compact binary: "KTRC", version, stats, count, then
+    //depth, row, col (16 bits each), digit and outcome (8 bits each)
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out.writeRawData("KTRC", 4);
+    out << quint8(1);
+    out << qint32(solveStats.nodes) << qint32(solveStats.maxDepth)
+        << qint32(solveStats.backtracks) << qint64(solveStats.restoreNsecs);
+    out << quint32(solveTrace.size());
+    for (int i = 0; i < int(solveTrace.size()); i++) {
+        out << quint16(solveTrace[i].depth)
+            << quint16(solveTrace[i].cell.row)
+            << quint16(solveTrace[i].cell.col)
+            << quint8(solveTrace[i].digit)
+            << quint8(solveTrace[i].outcome);
+    }
+    return out.status() == QDataStream::Ok;
 }
 
 void PuzzleBoard::giveMetaKnowledgeToCells() {
-    //Give clues their numInDownSum/numInRightSum and combos,
+    //Give clues their numInDownSum/numInRightSum,
     //and give nonclues their downClue and rightClue
     for (int r = 0; r < rows; r++) {
         for (int c = 0; c < cols; c++) {
@@ -1925,12 +948,6 @@ void PuzzleBoard::giveMetaKnowledgeToCells() {
                 cellArray[r][c2].setRightClue(cellArray[r][c].getRightClue());
                 cellArray[r][c].setNumInRightSum(cellArray[r][c].getNumInRightSum()+1);
             }
-
-
-            cellArray[r][c].setRightCombos(sumInNumCombo[cellArray[r][c].getRightClue()]
-                    [cellArray[r][c].getNumInRightSum()]);
-            cellArray[r][c].setDownCombos(sumInNumCombo[cellArray[r][c].getDownClue()]
-                    [cellArray[r][c].getNumInDownSum()]);
         }
     }
 
@@ -1962,116 +979,150 @@ void PuzzleBoard::giveMetaKnowledgeToCells() {
     }
 }
 
-void PuzzleBoard::setCellValueAndEraseNeighborNoteDups(CellPos cell, int val) {
-    int r = cell.row, c = cell.col;
-
-    cellArray[r][c].setValue(val);
-    for (int i = 0; i < 10; i++) {
-        cellArray[r][c].setNote(i, false);
-    }
-    if (!cellArray[r][c].getFixed()) {
-        cellArray[r][c].setNote(val, true);
+void PuzzleBoard::cellValueChanged(CellPos pos) {
+    generation++;
+    int index = pos.row*cols + pos.col;
+    bool wasSolved = runTracker.isSolved();
+    runTracker.setValue(index, cellArray[pos.row][pos.col].getValue());
+    markDirty(pos);
+    emit cellChanged(index, cellArray[pos.row][pos.col].getValue(),
+                     cellArray[pos.row][pos.col].getNoteMask());
+
+    //Only cells in the same runs can change their conflicts or
+    //candidates, and only the ones that did are redrawn
+    int runs[2] = { runTracker.getDownRun(index), runTracker.getRightRun(index) };
+    for (int n = 0; n < 2; n++) {
+        if (runs[n] == -1)
+            continue;
+        int stride = runTracker.getRunStride(runs[n]);
+        int i = runTracker.getRunFirst(runs[n]);
+        for (int k = 0; k < runTracker.getRunLength(runs[n]); k++, i += stride) {
+            if (!updateCellFromRuns(i))
+                continue;
+            markDirty({ i/cols, i%cols });
+            //Auto notes changed the cell's notes
+            if (autoNotes && i != index)
+                emit cellChanged(i, runTracker.getValue(i), cellArray[i/cols][i%cols].getNoteMask());
+        }
     }
 
-    //Remove dup notes on this cells row and col
-    for (int r2 = r-1; r2 >= 0; r2--) {
-        if (cellArray[r2][c].getType() == CLUE)
-            break;
-        cellArray[r2][c].setNote(val, false);
-    }
-    for (int r2 = r+1; r2 < rows; r2++) {
-        if (cellArray[r2][c].getType() == CLUE)
-            break;
-        cellArray[r2][c].setNote(val, false);
-    }
-    for (int c2 = c-1; c2 >= 0; c2--) {
-        if (cellArray[r][c2].getType() == CLUE)
-            break;
-        cellArray[r][c2].setNote(val, false);
-    }
-    for (int c2 = c+1; c2 < cols; c2++) {
-        if (cellArray[r][c2].getType() == CLUE)
-            break;
-        cellArray[r][c2].setNote(val, false);
-    }
+    if (!wasSolved && runTracker.isSolved())
+        emit boardSolved();
 }
 
-bool PuzzleBoard::hasEmptyCells() const {
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == CLUE)
-                continue;
-            if (cellArray[r][c].getValue() == 0)
-                return true;
-        }
-    }
+void PuzzleBoard::playerChangedCell(CellPos pos, int oldValue, quint16 oldNotes) {
+    const Cell &cell = cellArray[pos.row][pos.col];
+    history.record(pos.row*cols + pos.col, oldValue, oldNotes, cell.getValue(), cell.getNoteMask());
+    cellValueChanged(pos);
+}
 
-    return false;
+void PuzzleBoard::toggleNoteMode(CellPos pos) {
+    Cell &cell = cellArray[pos.row][pos.col];
+    int oldValue = cell.getValue();
+    quint16 oldNotes = cell.getNoteMask();
+    history.beginMove();
+    cell.setNote(0, !cell.getNote());
+
+    //Note mode isn't saved, so there's only something
+    //to record if the value or notes changed with it
+    if (cell.getValue() != oldValue || cell.getNoteMask() != oldNotes)
+        playerChangedCell(pos, oldValue, oldNotes);
+    else
+        markDirty(pos);
 }
 
-bool PuzzleBoard::checkSolved() const {
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (cellArray[r][c].getType() == NONCLUE) {
-                if (cellArray[r][c].getValue() == 0) {
-                    return false;
-                }
-                continue;
-            }
+bool PuzzleBoard::undo() {
+    if (!history.canUndo())
+        return false;
+
+    //Back to the edit that started the move
+    const EditHistory::Edit *edit;
+    do {
+        edit = &history.undo();
+        applyEdit(edit->cell, edit->oldValue, edit->oldNotes);
+    } while (!edit->moveStart);
+    return true;
+}
 
-            int dClue = cellArray[r][c].getDownClue();
-            int rClue = cellArray[r][c].getRightClue();
+bool PuzzleBoard::redo() {
+    if (!history.canRedo())
+        return false;
 
-            //Check down sum
-            if (dClue && getValidDownSumFromCell({ r, c }) != dClue) {
-                return false;
-            }
-            //Check right sum
-            if (rClue && getValidRightSumFromCell({ r, c }) != rClue) {
-                return false;
-            }
+    //Up to the edit that starts the next move
+    do {
+        const EditHistory::Edit &edit = history.redo();
+        applyEdit(edit.cell, edit.newValue, edit.newNotes);
+    } while (history.canRedo() && !history.getNextRedo().moveStart);
+    return true;
+}
+
+void PuzzleBoard::applyEdit(int index, int value, quint16 notes) {
+    Cell &cell = cellArray[index/cols][index%cols];
+    cell.setValue(value);
+    cell.setNoteMask(notes);
+    cellValueChanged({ index/cols, index%cols });
+}
+
+void PuzzleBoard::applyJournalEntry(int index, int value, quint16 notes) {
+    if (index < 0 || index >= rows*cols || value < 0 || value > 9)
+        return;
+    const Cell &cell = cellArray[index/cols][index%cols];
+    if (cell.getType() == CLUE || cell.getFixed())
+        return;
+
+    applyEdit(index, value, notes);
+}
+
+void PuzzleBoard::updateRunTracker() {
+    generation++;
+    runTracker.load(boardModel);
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            if (cellArray[r][c].getType() == NONCLUE)
+                runTracker.setValue(r*cols + c, cellArray[r][c].getValue());
         }
     }
-
-    return true;
+    for (int i = 0; i < rows*cols; i++) {
+        if (updateCellFromRuns(i))
+            markDirty({ i/cols, i%cols });
+    }
+    emit cellsReplaced();
 }
 
-int PuzzleBoard::getValidDownSumFromCell(CellPos pos) const {
-    int sum = 0, v;
-    bool used[10];
-    for (int i = 0; i < 10; i++)
-        used[i] = 0;
+bool PuzzleBoard::updateCellFromRuns(int index) {
+    Cell *cellPtr = &cellArray[index/cols][index%cols];
+    if (cellPtr->getType() == CLUE)
+        return false;
 
-    for (int r = pos.row+1; r < rows; r++) {
-        if (cellArray[r][pos.col].getType() == CLUE) break;
-        v = cellArray[r][pos.col].getValue();
-        //Can't repeat numbers
-        if (used[v])
-            return -1;
-        used[v] = true;
-        sum += v;
+    bool changed = false;
+    bool conflict = runTracker.hasConflict(index);
+    if (cellPtr->getConflict() != conflict) {
+        cellPtr->setConflict(conflict);
+        changed = true;
     }
 
-    return sum;
+    //Filled cells don't need notes
+    if (autoNotes && !cellPtr->getFixed()) {
+        quint16 notes = cellPtr->getValue() ? 0 : runTracker.getCandidates(index);
+        if (cellPtr->getNoteMask() != notes) {
+            cellPtr->setNoteMask(notes);
+            changed = true;
+        }
+    }
+    return changed;
 }
 
-int PuzzleBoard::getValidRightSumFromCell(CellPos pos) const {
-    int sum = 0, v;
-    bool used[10];
-    for (int i = 0; i < 10; i++)
-        used[i] = 0;
+void PuzzleBoard::setAutoNotes(bool a) {
+    autoNotes = a;
+    if (!autoNotes)
+        return;
+    generation++;
 
-    for (int c = pos.col+1; c < cols; c++) {
-        if (cellArray[pos.row][c].getType() == CLUE) break;
-        v = cellArray[pos.row][c].getValue();
-        //Can't repeat numbers
-        if (used[v])
-            return -1;
-        used[v] = true;
-        sum += v;
+    for (int i = 0; i < rows*cols; i++) {
+        if (updateCellFromRuns(i))
+            markDirty({ i/cols, i%cols });
     }
-
-    return sum;
+    emit cellsReplaced();
 }
 
 CellPos PuzzleBoard::getFirstNonClueCell() const {
@@ -2158,10 +1209,8 @@ void PuzzleBoard::keyPressEvent(QKeyEvent * event) {
         //Toggle notes
         if (selectedCell.row != -1 && selectedCell.col != -1) {
             Cell *cPtr = &cellArray[selectedCell.row][selectedCell.col];
-            if (cPtr->getType() == NONCLUE && !cPtr->getFixed()) {
-                cPtr->setNote(0, !cPtr->getNote());
-                cPtr->draw();
-            }
+            if (cPtr->getType() == NONCLUE && !cPtr->getFixed())
+                toggleNoteMode(selectedCell);
         }
         break;
     case Qt::Key_0:
@@ -2175,7 +1224,12 @@ void PuzzleBoard::keyPressEvent(QKeyEvent * event) {
     case Qt::Key_8:
     case Qt::Key_9:
         if (selectedCell.row != -1 && selectedCell.col != -1) {
-            cellArray[selectedCell.row][selectedCell.col].handleNumPress(event->key() - Qt::Key_0);
+            Cell *cellPtr = &cellArray[selectedCell.row][selectedCell.col];
+            int oldValue = cellPtr->getValue();
+            quint16 oldNotes = cellPtr->getNoteMask();
+            history.beginMove();
+            cellPtr->handleNumPress(event->key() - Qt::Key_0);
+            playerChangedCell(selectedCell, oldValue, oldNotes);
         }
         break;
     case Qt::Key_Shift:
@@ -2186,8 +1240,10 @@ void PuzzleBoard::keyPressEvent(QKeyEvent * event) {
             Cell *cellPtr = &cellArray[selectedCell.row][selectedCell.col];
             if (cellPtr->getFixed()) break;
             if (cellPtr->getNote() == 0) {
-                cellPtr->setValue(cellPtr->getValue()+1);
-                cellPtr->draw();
+                int oldValue = cellPtr->getValue();
+                history.beginMove();
+                cellPtr->setValue(oldValue+1);
+                playerChangedCell(selectedCell, oldValue, cellPtr->getNoteMask());
             }
         }
         break;
@@ -2199,8 +1255,10 @@ void PuzzleBoard::keyPressEvent(QKeyEvent * event) {
             Cell *cellPtr = &cellArray[selectedCell.row][selectedCell.col];
             if (cellPtr->getFixed()) break;
             if (cellPtr->getNote() == 0) {
-                cellPtr->setValue(cellPtr->getValue()-1);
-                cellPtr->draw();
+                int oldValue = cellPtr->getValue();
+                history.beginMove();
+                cellPtr->setValue(oldValue-1);
+                playerChangedCell(selectedCell, oldValue, cellPtr->getNoteMask());
             }
         }
         break;
@@ -2213,6 +1271,13 @@ void PuzzleBoard::keyPressEvent(QKeyEvent * event) {
     }
 }
 
+void PuzzleBoard::selectCell(CellPos pos) {
+    if (pos.row == selectedCell.row && pos.col == selectedCell.col)
+        return;
+    toggleSelectOnCell(selectedCell);
+    toggleSelectOnCell(pos);
+}
+
 void PuzzleBoard::toggleSelectOnCell(CellPos pos) {
     if (pos.row == -1 || pos.col == -1) {
         return;
@@ -2228,7 +1293,44 @@ void PuzzleBoard::toggleSelectOnCell(CellPos pos) {
     else {
         cellArray[pos.row][pos.col].select();
         selectedCell = pos;
+        //Selected some other way than by the mouse, so moving
+        //the mouse in the cell it's over selects that one again
+        if (pos.row != hoverCell.row || pos.col != hoverCell.col)
+            hoverCell = { -1, -1 };
+    }
+    markDirty(pos);
+}
+
+void PuzzleBoard::queueMouseMove(CellPos pos) {
+    //Moves within the cell that was already handled change nothing
+    if (pos.row == hoverCell.row && pos.col == hoverCell.col) {
+        pendingHoverCell = { -1, -1 };
+        return;
     }
+
+    //Handle it now if a frame has gone by since the last one,
+    //otherwise keep only the latest until one has
+    bool scheduled = pendingHoverCell.row != -1;
+    pendingHoverCell = pos;
+    if (scheduled)
+        return;
+
+    qint64 elapsed = mouseMoveTimer.elapsed();
+    if (elapsed >= MOUSE_MOVE_INTERVAL)
+        flushMouseMove();
+    else
+        QTimer::singleShot(MOUSE_MOVE_INTERVAL - int(elapsed), this, SLOT(flushMouseMove()));
+}
+
+void PuzzleBoard::flushMouseMove() {
+    CellPos pos = pendingHoverCell;
+    if (pos.row == -1)
+        return;
+
+    pendingHoverCell = { -1, -1 };
+    hoverCell = pos;
+    mouseMoveTimer.restart();
+    handleMouseMove(pos);
 }
 
 void PuzzleBoard::handleMouseMove(CellPos pos) {
@@ -2239,11 +1341,8 @@ void PuzzleBoard::handleMouseMove(CellPos pos) {
                 cellArray[pos.row][pos.col].getFixed()) {
             toggleSelectOnCell(selectedCell);
             selectedCell = { -1, -1 };
-            //...and you're dragging something
-            if (draggingCell.row != -1 && draggingCell.col != -1) {
-                //....draw it at full opacity
-                cellArray[draggingCell.row][draggingCell.col].draw();
-            }
+            //...and you're dragging something, draw it at full opacity
+            markDirty(draggingCell);
         }
         //..and the cell is NOT a clue
         else {
@@ -2251,19 +1350,9 @@ void PuzzleBoard::handleMouseMove(CellPos pos) {
             toggleSelectOnCell(selectedCell);
             toggleSelectOnCell(pos);
 
-            //...and you're dragging something
-            if (draggingCell.row != -1 && draggingCell.col != -1) {
-                //Pointers to shave line length
-                Cell *dPtr = &cellArray[draggingCell.row][draggingCell.col];
-                Cell *pPtr = &cellArray[pos.row][pos.col];
-                //Get the value of drag-from
-                int dragN = dPtr->getValue();
-                //Draw a 0 on dragFrom, and the drag value on dragTo
-                dPtr->drawValue(0, DRAG_OPACITY);
-                dPtr->drawNotes(0.5);
-                pPtr->drawValue(dragN, DRAG_OPACITY);
-                pPtr->drawNotes(0.5);
-            }
+            //...and you're dragging something, draw
+            //it moved from dragFrom to dragTo
+            markDirty(draggingCell);
         }
     }
 }
@@ -2274,8 +1363,8 @@ void PuzzleBoard::handleMouseLeftPress(CellPos pos) {
         //...start dragging it, if it has a value
         if (cellArray[pos.row][pos.col].getValue() &&
                 !cellArray[pos.row][pos.col].getFixed()) {
-            cellArray[pos.row][pos.col].draw(DRAG_OPACITY);
             draggingCell = pos;
+            markDirty(pos);
         }
     }
 }
@@ -2285,8 +1374,9 @@ void PuzzleBoard::handleMouseRightPress(CellPos pos) {
     if (cellArray[pos.row][pos.col].getType() == CLUE) {
         //Clear the appropriate row/column
         //Down clue
-        if (cellArray[pos.row][pos.col].getLabel()->mapFromGlobal(QCursor::pos()).y() >
-                cellArray[pos.row][pos.col].getLabel()->mapFromGlobal(QCursor::pos()).x()) {
+        QPoint inCell = mapFromGlobal(QCursor::pos()) - cellArray[pos.row][pos.col].getRect().topLeft();
+        history.beginMove();
+        if (inCell.y() > inCell.x()) {
             clearColumnFrom(pos);
         }
         //Right clue
@@ -2297,8 +1387,7 @@ void PuzzleBoard::handleMouseRightPress(CellPos pos) {
     //If it's not a clue
     else if (!cellArray[pos.row][pos.col].getFixed()){
         //Toggle notes
-        cellArray[pos.row][pos.col].setNote(0, !cellArray[pos.row][pos.col].getNote());
-        cellArray[pos.row][pos.col].draw();
+        toggleNoteMode(pos);
     }
 }
 
@@ -2307,22 +1396,26 @@ void PuzzleBoard::handleMouseLeftRelease(CellPos pos) {
     if (pos.row == draggingCell.row && pos.col == draggingCell.col) {
         draggingCell = { -1, -1 };
         cellArray[pos.row][pos.col].setNote(0, false);
-        cellArray[pos.row][pos.col].draw();
+        markDirty(pos);
         return;
     }
 
     //If you're dragging and dropping
     if (draggingCell.row != -1 && draggingCell.col != -1) {
-        cellArray[draggingCell.row][draggingCell.col].draw();
+        markDirty(draggingCell);
         //..and if you're not releasing on a clue
         if (cellArray[pos.row][pos.col].getType() == NONCLUE &&
                 !cellArray[pos.row][pos.col].getFixed()) {
             //...drop the drag cell value on the drop cell
-            int dragV = cellArray[draggingCell.row][draggingCell.col].getValue();
-            cellArray[draggingCell.row][draggingCell.col].setValue(0);
-            cellArray[draggingCell.row][draggingCell.col].draw();
-            cellArray[pos.row][pos.col].setValue(dragV);
-            cellArray[pos.row][pos.col].draw();
+            Cell *fromPtr = &cellArray[draggingCell.row][draggingCell.col];
+            Cell *toPtr = &cellArray[pos.row][pos.col];
+            int dragV = fromPtr->getValue();
+            int oldValue = toPtr->getValue();
+            history.beginMove();
+            fromPtr->setValue(0);
+            playerChangedCell(draggingCell, dragV, fromPtr->getNoteMask());
+            toPtr->setValue(dragV);
+            playerChangedCell(pos, oldValue, toPtr->getNoteMask());
 
         }
         draggingCell = { -1, -1 };
@@ -2330,15 +1423,24 @@ void PuzzleBoard::handleMouseLeftRelease(CellPos pos) {
 }
 
 void PuzzleBoard::handleMouse(QMouseEvent * mouseEvent) {
-    CellPos pos = { (mapFromGlobal(QCursor::pos()).y())/cellSize,
-                    (mapFromGlobal(QCursor::pos()).x())/cellSize};
+    QPoint point = mapFromGlobal(QCursor::pos());
+    CellPos pos = { point.y()/cellSize, point.x()/cellSize };
+    if (pos.row < 0 || pos.row >= rows || pos.col < 0 || pos.col >= cols)
+        return;
 
     //Mouse movement
     if (mouseEvent->type() == QEvent::MouseMove || mouseEvent->type() == QEvent::HoverMove) {
-        handleMouseMove(pos);
+        queueMouseMove(pos);
+        return;
     }
+
+    //Clicks happen where the mouse is now, so catch up
+    //on the move that's waiting first
+    if (pendingHoverCell.row != -1)
+        flushMouseMove();
+
     //Mouse button press
-    else if (mouseEvent->type() == QEvent::MouseButtonPress) {
+    if (mouseEvent->type() == QEvent::MouseButtonPress) {
         if (mouseEvent->button() == Qt::RightButton) {
             handleMouseRightPress(pos);
         }
@@ -2361,10 +1463,12 @@ void PuzzleBoard::clearColumnFrom(CellPos pos) {
             break;
         if (cellArray[r][pos.col].getFixed())
             continue;
+        int oldValue = cellArray[r][pos.col].getValue();
+        quint16 oldNotes = cellArray[r][pos.col].getNoteMask();
         cellArray[r][pos.col].setValue(0);
         for (int i = 0; i < 10; i++)
             cellArray[r][pos.col].setNote(i, 0);
-        cellArray[r][pos.col].draw();
+        playerChangedCell({ r, pos.col }, oldValue, oldNotes);
     }
 }
 
@@ -2374,10 +1478,12 @@ void PuzzleBoard::clearRowFrom(CellPos pos) {
             break;
         if (cellArray[pos.row][c].getFixed())
             continue;
+        int oldValue = cellArray[pos.row][c].getValue();
+        quint16 oldNotes = cellArray[pos.row][c].getNoteMask();
         cellArray[pos.row][c].setValue(0);
         for (int i = 0; i < 10; i++)
             cellArray[pos.row][c].setNote(i, 0);
-        cellArray[pos.row][c].draw();
+        playerChangedCell({ pos.row, c }, oldValue, oldNotes);
     }
 }
 
@@ -2408,20 +1514,31 @@ void PuzzleBoard::setCellSize(int s) {
         return;
 
     cellSize = s;
+    generation++;
 
     for (int r = 0; r < rows; r++) {
         for (int c = 0; c < cols; c++) {
             cellArray[r][c].setSize(cellSize);
-            cellArray[r][c].makePixmap();
         }
     }
+    glyphCache.setSize(cellSize);
+    markAllDirty();
 
     //Set size of board
     setFixedSize(cols*cellSize, rows*cellSize);
 }
 
-QString PuzzleBoard::generateBoard(int rows, int cols) const {
+QString PuzzleBoard::generateBoard(int rows, int cols, int cellSize, CancelToken *token,
+                                   const SolveLimits &limits, SolveStatus *status,
+                                   FingerprintSet *seen) {
+    QElapsedTimer generateTimer;
+    generateTimer.start();
+    int assignmentsTried = 0;
+
     QVector<CellInfo> cells;
+    //Reused by every attempt in phase three
+    BoardModel model;
+    BatchSolver batch;
     bool makeNewBoard;
     do {
         makeNewBoard = false;
@@ -2432,6 +1549,11 @@ QString PuzzleBoard::generateBoard(int rows, int cols) const {
         //every clue group size is >= 2 and <= 9
         bool contiguous;
         do {
+            SolveStatus stopStatus = getGenerateStopStatus(token, limits, generateTimer, assignmentsTried);
+            if (stopStatus != SOLVE_SOLVED) {
+                if (status) *status = stopStatus;
+                return QString();
+            }
             cells.clear();
 
             //Phase One: Part 1
@@ -2622,6 +1744,10 @@ QString PuzzleBoard::generateBoard(int rows, int cols) const {
 
         bool makeNewClues = false;
         int tries = 0;
+        //Clue assignments for this layout
+        QVector<QVector<CellInfo> > candidates;
+        //Their fingerprints, to not solve the same one twice
+        QSet<Fingerprint> candidatePrints;
         do {
             if (tries > 0.5*(rows+cols)) {
                 makeNewBoard = true;
@@ -2630,6 +1756,16 @@ QString PuzzleBoard::generateBoard(int rows, int cols) const {
             tries++;
             makeNewClues = false;
 
+            //Progress is the number of clue assignments tried
+            SolveStatus stopStatus = getGenerateStopStatus(token, limits, generateTimer, assignmentsTried);
+            if (stopStatus != SOLVE_SOLVED) {
+                if (status) *status = stopStatus;
+                return QString();
+            }
+            assignmentsTried++;
+            if (token)
+                token->setProgress(assignmentsTried);
+
             //Phase Two: Part One
             //Start filling in nonclues as legally as possible.
             //If we run into a contradiction somewhere, just restart
@@ -2764,110 +1900,145 @@ QString PuzzleBoard::generateBoard(int rows, int cols) const {
                 }
             }
 
+            //Collect a few clue assignments for phase three,
+            //skipping ones that came out the same as another
+            Fingerprint print = CanonicalForm(rows, cols, cells).getFingerprint();
+            if (!candidatePrints.contains(print)) {
+                candidatePrints.insert(print);
+                candidates.push_back(cells);
+            }
+            if (candidates.size() < GENERATE_BATCH && tries <= 0.5*(rows+cols)) {
+                makeNewClues = true;
+                continue;
+            }
+
             //PHASE THREE (last one!)
-            //Now that we have a working Kakuro board,
-            //we need it to have a unique solution. We'll accomplish
+            //Now that we have working Kakuro boards,
+            //we need one to have a unique solution. We'll accomplish
             //this by fixing nonclue cells on possible values until
-            //the board is solvable using our logic, restarting when necessary
+            //a board is solvable using our logic, restarting when necessary.
+            //The boards share a layout, so they're solved in lockstep
 
-            PuzzleBoard *board = new PuzzleBoard(convertCellsInfoToKAKString(rows, cols, cells));
+            //The generated numbers are ignored, since they aren't fixed
+            model.load(rows, cols, candidates[0]);
+            batch.load(model, candidates.size());
+            for (int lane = 0; lane < batch.getNumLanes(); lane++) {
+                model.load(rows, cols, candidates[lane]);
+                batch.setLane(lane, model);
+            }
 
             //LOGIC METHOD
-            bool solved = board->solve(false);
+            batch.propagate();
 
 
             //Do a little foresight -- are there a lot of notes?
-            //If so, just make some new clues to save time
-            int noteCount = 0, unsolvedCellCount = 0;
-            for (int r = 0; r < board->rows; r++) {
-                for (int c = 0; c < board->cols; c++) {
-                    if (board->cellArray[r][c].getType() == CLUE)
-                        continue;
-                    if (board->cellArray[r][c].getValue())
+            //If so, drop that board to save time
+            for (int lane = 0; lane < batch.getNumLanes(); lane++) {
+                if (batch.getStatus(lane) != BatchSolver::LANE_UNSOLVED)
+                    continue;
+
+                int noteCount = 0, unsolvedCellCount = 0;
+                for (int i = 0; i < batch.getNumCells(); i++) {
+                    int cellNotes = qPopulationCount(batch.getMask(lane, i));
+                    if (batch.isClue(i) || cellNotes < 2)
                         continue;
 
                     unsolvedCellCount++;
-                    for (int n = 1; n < 10; n++) {
-                        if (board->cellArray[r][c].getNote(n)) {
-                            noteCount++;
-                        }
-                    }
+                    noteCount += cellNotes;
                 }
-            }
-            if (noteCount > 8*unsolvedCellCount) {
-                makeNewClues = true;
-                continue;
+                if (noteCount > 8*unsolvedCellCount)
+                    batch.dropLane(lane);
             }
 
 
             //Keep fixing unsolved cells to possible values
-            while (!solved) {
-                bool quit = false;
-                //Find the cell with the least number of notes
-                int minNotes = 10, note = 0;
-                CellPos cell = { -1, -1 };
-                for (int r = 0; r < board->rows; r++) {
-                    if (quit) break;
-                    for (int c = 0; c < board->cols; c++) {
-                        if (quit) break;
-                        if (board->cellArray[r][c].getType() == CLUE)
-                            continue;
-                        if (board->cellArray[r][c].getValue())
-                            continue;
-                        if (board->cellArray[r][c].getFixed())
+            int solvedLane = -1;
+            bool fixedAny = true;
+            while (solvedLane == -1 && fixedAny) {
+                fixedAny = false;
+                for (int lane = 0; lane < batch.getNumLanes(); lane++) {
+                    if (batch.getStatus(lane) == BatchSolver::LANE_SOLVED) {
+                        solvedLane = lane;
+                        break;
+                    }
+                    if (batch.getStatus(lane) != BatchSolver::LANE_UNSOLVED)
+                        continue;
+
+                    //Find the cell with the least number of notes
+                    int minNotes = 10, note = 0;
+                    int cell = -1;
+                    for (int i = 0; i < batch.getNumCells(); i++) {
+                        if (batch.isClue(i) || batch.getFixed(lane, i))
                             continue;
 
-                        int noteCount = 0, lastNote = 0;
-                        for (int n = 1; n < 10; n++) {
-                            if (board->cellArray[r][c].getNote(n)) {
-                                noteCount++;
-                                if (noteCount > minNotes)
-                                    break;
-                                lastNote = n;
-                            }
-                        }
-                        //We broke something, can't be solved anymore
-                        if (noteCount == 0 || noteCount == 1) {
-                            makeNewClues = true;
-                            quit = true;
-                            break;
-                        }
+                        quint16 mask = batch.getMask(lane, i);
+                        int noteCount = qPopulationCount(mask);
+                        if (noteCount < 2)
+                            continue;
                         if (noteCount < minNotes) {
                             minNotes = noteCount;
-                            cell = { r, c };
-                            note = lastNote;
+                            cell = i;
+                            //Last note
+                            note = 9;
+                            while (!(mask & (1 << note)))
+                                note--;
                         }
                         if (minNotes == 2)
                             break;
                     }
-                }
-                if (cell.row == -1 || cell.col == -1 ||
-                        board->cellArray[cell.row][cell.col].getFixed())
-                    makeNewClues = true;
-                if (makeNewClues)
-                    break;
+                    //We broke something, can't be solved anymore
+                    if (cell == -1) {
+                        batch.dropLane(lane);
+                        continue;
+                    }
 
-                //Fix that cell to one of its notes
-                board->cellArray[cell.row][cell.col].setValue(note);
-                board->cellArray[cell.row][cell.col].setFixed(true);
-                for (int n2 = 1; n2 < 10; n2++) {
-                    board->cellArray[cell.row][cell.col].setNote(n2, false);
+                    //Fix that cell to one of its notes
+                    batch.fixCell(lane, cell, note);
+                    fixedAny = true;
                 }
 
                 //Try to solve again
-                solved = board->solve(false);
+                if (solvedLane == -1 && fixedAny)
+                    batch.propagate();
+            }
+            if (solvedLane == -1) {
+                candidates.clear();
+                candidatePrints.clear();
+                makeNewClues = true;
+                continue;
             }
-            //Unique solution! Get info
-            board->clearBoard();
-            cells = board->getCellsInfoFromCellArray();
 
-            delete board;
+            //Unique solution! Get info
+            model.load(rows, cols, candidates[solvedLane]);
+            batch.store(solvedLane, model);
+            model.clearValues();
+
+            //Start over if it's been made before
+            if (seen && !seen->insert(CanonicalForm(model).getFingerprint())) {
+                candidates.clear();
+                candidatePrints.clear();
+                makeNewClues = true;
+                continue;
+            }
+            model.store(cells);
 
         } while (makeNewClues);
 
     } while (makeNewBoard);
 
-    return convertCellsInfoToKAKString(rows, cols, cells);
+    if (status) *status = SOLVE_SOLVED;
+    return convertCellsInfoToKAKString(rows, cols, cellSize, cells);
+}
+
+static SolveStatus getGenerateStopStatus(const CancelToken *token, const SolveLimits &limits,
+                                         const QElapsedTimer &timer, int assignmentsTried) {
+    if (token && token->isCancelled())
+        return SOLVE_CANCELLED;
+    if (limits.maxNodes && assignmentsTried >= limits.maxNodes)
+        return SOLVE_OUT_OF_NODES;
+    if (limits.timeLimitMsecs && timer.hasExpired(limits.timeLimitMsecs))
+        return SOLVE_TIMED_OUT;
+    return SOLVE_SOLVED;
 }
 
 void floodFill(int index, QVector<bool> & filled, QVector<bool> map, int rows, int cols) {
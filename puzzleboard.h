@@ -3,13 +3,14 @@
  *
  * The PuzzleBoard is where the Kakuro is actually located.
  * It handles keyboard and mouse input used to play the game.
- * It also includes the solving and generating functions.
+ * It also includes the generating function, and solves
+ * using its Solver (see solver.h).
  *
- * Its data includes a two-dimensional array of Cells (cellArray),
- * a vector of CellInfos that is a barebones representation
- * of cellArray (used for faster calculations), and an array of
- * vectors of vectors of ints (sumInNumCombo[SUM][NUM])
- * used to store the combinations of every "sum" in "num."
+ * Its data includes a flat pool of Cells (cellArray points at
+ * the start of each row), a BoardModel of the clues and fixed
+ * cells, and an array of vectors of vectors of ints
+ * (sumInNumCombo[SUM][NUM]) used to store the combinations
+ * of every "sum" in "num."
  *
  * See note in mainwindow.h about KAKStrings.
  *
@@ -20,63 +21,160 @@
 
 #include <QWidget>
 #include <QMainWindow>
-#include <QGridLayout>
-#include <QPixmap>
 #include <QPainter>
 #include <QTextStream>
+#include <QElapsedTimer>
 #include "cell.h"
+#include "solver.h"
+#include "batchsolver.h"
+#include "runtracker.h"
+#include "edithistory.h"
+#include "fingerprint.h"
 #include "common.h"
 
 class PuzzleBoard : public QWidget {
     Q_OBJECT
 
 public:
+    //Copy of everything a KAKString is made from, so the
+    //string can be made on another thread (see makeKAKString())
+    struct Snapshot {
+        int rows, cols, cellSize;
+        QVector<CellInfo> cells;
+        QString time;
+    };
+
     PuzzleBoard(QString s = 0);
     ~PuzzleBoard();
 
     void clearBoard();
 
+    //Undoes or redoes the player's last move. Loading, resetting
+    //or solving the board starts the history over
+    bool undo();
+    bool redo();
+    bool canUndo() const { return history.canUndo(); }
+    bool canRedo() const { return history.canRedo(); }
+    //Puts a cell's value and notes back from a save's journal
+    //(see MainWindow). Entries that don't fit the board are skipped
+    void applyJournalEntry(int index, int value, quint16 notes);
+
     //Events
     void keyPressEvent(QKeyEvent * event);
     void handleMouse(QMouseEvent * mouseEvent);
+    void paintEvent(QPaintEvent * event);
 
     //KAKString and saving/loading
     void makeBoardFromKAKString(QString s);
     bool lazyValidateKAKString(QString s) const;
     QString getKAKString() const;
+    Snapshot getSnapshot() const;
+    static QString makeKAKString(const Snapshot &snapshot);
     QString getTimeFormatted() const;
 
     //Solving related
+    //Puts the solution on the board, or if there isn't one,
+    //as much as the solver got. Cached solutions are used
     bool solve(bool useBruteForce = true);
-    bool checkSolved() const;
+    //Whether the player has solved the board. This is
+    //kept up to date on every move, so it's cheap
+    bool checkSolved() const { return runTracker.isSolved(); }
+    //Whether the board can be solved, checked on a copy of its
+    //clues and fixed cells. Nothing on the board changes
+    SolveStatus checkSolvable(const SolveLimits &limits = SolveLimits());
+    //Copy of the board for solving elsewhere (e.g. another thread),
+    //and putting a solved copy back
+    BoardModel getBoardModel() const;
+    void setFromBoardModel(const BoardModel &model);
+    void setSolveResults(const SolveStats &stats, const QVector<SolveTraceEntry> &trace,
+                         const QVector<SolveStep> &steps = QVector<SolveStep>());
+    //Replaying the last solve. Step n shows the board after the
+    //first n steps of the log, and only the cells that change
+    //on the way there are redrawn. The board is left at the
+    //last step when a solve finishes
+    int getNumSolveSteps() const { return solveSteps.size(); }
+    const SolveStep &getSolveStep(int i) const { return solveSteps[i]; }
+    int getReplayStep() const { return replayStep; }
+    void showSolveStep(int step);
+    //The next number logic can place from the player's numbers
+    //and notes. Nothing on the board changes
+    SolveHint getHint();
 
-    //Returns KAKString of generated board with unique solution
-    QString generateBoard(int rows, int cols) const;
+    //Returns KAKString of generated board with unique solution,
+    //or an empty string if it was cancelled or ran out of time/tries
+    //(status says which). If seen is given, boards already in it
+    //(or their transposes) are thrown away, and the new board is added
+    static QString generateBoard(int rows, int cols, int cellSize, CancelToken *token = 0,
+                                 const SolveLimits &limits = SolveLimits(),
+                                 SolveStatus *status = 0, FingerprintSet *seen = 0);
+    //Fingerprint of the clues and fixed cells
+    Fingerprint getFingerprint() const;
 
     //Accessors
     int getCellSize() const { return cellSize; }
     int getRows() const { return rows; }
     int getCols() const { return cols; }
+    CellPos getSelectedCell() const { return selectedCell; }
     int getSeconds() const { return seconds; }
+    //Goes up whenever anything that's saved (other than the time)
+    //changes, so a board that hasn't changed since it was saved
+    //can be told apart without making its KAKString
+    quint64 getGeneration() const { return generation; }
     QVector<QVector<int>> getSumInNum(int s, int n) const { return sumInNumCombo[s][n]; }
+    SolveStats getSolveStats() const { return solveStats; }
+    QVector<SolveTraceEntry> getSolveTrace() const { return solveTrace; }
+    bool getTraceEnabled() const { return traceEnabled; }
+    bool getAutoNotes() const { return autoNotes; }
+
+    //Writes the trace of the last solve, as JSON if the
+    //file name ends in .json and as compact binary otherwise
+    bool exportSolveTrace(const QString &fileName) const;
 
     //Mutators
+    void selectCell(CellPos pos);
     void setCellSize(int s);
     void setRows(int r) { if (r < 0) return; rows = r; }
     void setCols(int c) { if (c < 0) return; cols = c; }
     void setSeconds(int s) { if (s < 0) return; seconds = s; }
     void setColor(int whichColor, QColor *color);
+    void setTraceEnabled(bool t) { traceEnabled = t; }
+    //With auto notes on, the notes of every empty cell are kept
+    //to the numbers that still fit its runs
+    void setAutoNotes(bool a);
 
 public slots:
+    //Redraws every cell (e.g. after the colors or cell size change)
     void drawBoard();
 
+signals:
+    //Emitted when a move by the player solves the board
+    void boardSolved();
+    //Emitted for each cell a move (or undo/redo) changes
+    void cellChanged(int index, int value, int notes);
+    //Emitted when many cells may have changed at once (loading,
+    //resetting, solving, or auto notes being turned on)
+    void cellsReplaced();
+
+private slots:
+    void flushMouseMove();
+
 private:
     //Events
+    //Mouse moves are coalesced: at most one is handled per
+    //frame, and only if it's over a different cell
+    void queueMouseMove(CellPos pos);
     void handleMouseMove(CellPos pos);
     void handleMouseLeftPress(CellPos pos);
     void handleMouseRightPress(CellPos pos);
     void handleMouseLeftRelease(CellPos pos);
 
+    //Drawing. Cells are marked dirty when something about them
+    //changes, and the dirty ones that are on screen are painted
+    //together once control gets back to the event loop
+    void markDirty(CellPos pos);
+    void markAllDirty();
+    void drawCell(QPainter &painter, CellPos pos);
+
     //General utility
     void initSumInNumCombos();
     void toggleSelectOnCell(CellPos pos);
@@ -84,10 +182,21 @@ private:
     void clearRowFrom(CellPos pos);
     CellPos getFirstNonClueCell() const;
     CellPos getNextNonClueCell(int dir) const;
-    int getValidDownSumFromCell(CellPos pos) const;
-    int getValidRightSumFromCell(CellPos pos) const;
-    int getMinNoteForCell(CellPos pos) const;
-    int getMaxNoteForCell(CellPos pos) const;
+    //Updates the runs, conflicts, and solved state
+    //after the player changes a cell's value
+    void cellValueChanged(CellPos pos);
+    //Records the player's change to a cell in the history,
+    //then does cellValueChanged()
+    void playerChangedCell(CellPos pos, int oldValue, quint16 oldNotes);
+    //Turns note mode on or off for a cell, as its own move
+    void toggleNoteMode(CellPos pos);
+    //Puts a value and notes on a cell from the history
+    void applyEdit(int index, int value, quint16 notes);
+    //Rebuilds runTracker from all the cells
+    void updateRunTracker();
+    //Sets a cell's conflict (and, with auto notes, its notes)
+    //from runTracker. Returns whether the cell needs redrawing
+    bool updateCellFromRuns(int index);
 
     //KAKString and saving/loading
     void makeNewCellArray(int newRows, int newCols);
@@ -95,52 +204,68 @@ private:
     void updateCellArray();
     void updateCellArray(QVector<CellInfo> info);
     void setCellsInfo(QString s);
-    QString convertCellsInfoToKAKString(int rows, int cols, QVector<CellInfo> info) const;
+    static QString convertCellsInfoToKAKString(int rows, int cols, int cellSize, QVector<CellInfo> info);
 
     //Solving related
-    void putBackFixedValues();
     void giveMetaKnowledgeToCells();
-    bool updateClueCellCombos();
-    void setCellValueAndEraseNeighborNoteDups(CellPos cell, int val);
-    bool* getIntersectNotesForCell(CellPos pos) const;
-    bool writeNotesFromIntersections();
-    void removeNotesFixedValues();
-    bool logicSolve(bool lazy);
-    bool writeCellsWithOneNoteAndRemoveDupNotes();
-    bool adjustNotesByLogicalRange();
-    bool solveUniquesWithOneEmpty();
-    bool removeExtraNotesFromUniques();
-    bool solveCellsWithNecessaryValue();
-    bool removeNotesNotInPossibleCombos();
-    bool removeNotesNotInPossiblePerms();
-    bool smartBruteForceSolve();
-    bool hasEmptyCells() const;
 
     //Number of rows, cols, and cellSize
     int rows, cols, cellSize;
 
     CellPos selectedCell, draggingCell;
+    //The cell the last handled mouse move was over, and the latest
+    //one waiting for flushMouseMove() (-1, -1 if none is)
+    CellPos hoverCell, pendingHoverCell;
+    QElapsedTimer mouseMoveTimer;
 
     //Seconds passed
     int seconds;
+    quint64 generation;
 
     //Info about the cells, used for storing/loading board
     //configurations. Not guaranteed to be in sync with cellArray cells
     QVector<CellInfo> cellsInfo;
-    //2D array for cells
-    Cell **cellArray;
-    //Grid layout for cells
-    QGridLayout *gridLayout;
+    //Every cell, row by row, and a pointer to the start of each
+    //row so cells can be used as cellArray[row][col]. The storage
+    //is reused by every board loaded after this one
+    QVector<Cell> cellPool;
+    QVector<Cell*> cellArray;
+    //Pre-rendered text for the cells, for the current size and colors
+    GlyphCache glyphCache;
 
     //Sum combinations
     QVector<QVector<int>> sumInNumCombo[46][10];
     //Does the sum in num have only one combo?
     bool sumInNumIsUnique[46][10];
 
+    //Clues and fixed cells, kept from when the board was loaded.
+    //Solving starts from a copy of this instead of reading the cells
+    BoardModel boardModel;
+    //Solves and checks it. Kept, so its run memo is too
+    Solver boardSolver;
+
+    //Sums, used numbers and filled counts of the runs being played
+    RunTracker runTracker;
+    Solver hintSolver;
+    bool autoNotes;
+
+    //The player's moves, for undo/redo
+    EditHistory history;
+
+    //Results of the last solve, and whether it should record a solve trace
+    //(and step log). replayStep is the step of the log the board shows
+    SolveStats solveStats;
+    QVector<SolveTraceEntry> solveTrace;
+    QVector<SolveStep> solveSteps;
+    int replayStep;
+    bool traceEnabled;
+
     const qreal DRAG_OPACITY = 0.7;
+    //Shortest time between handled mouse moves, in ms
+    const int MOUSE_MOVE_INTERVAL = 16;
 
     //Colors
-    QColor *colors[7];
+    QColor *colors[8];
 };
 
 #endif
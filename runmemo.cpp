@@ -0,0 +1,162 @@
+/*
+ * runmemo.cpp
+ * See runmemo.h for more information
+ */
+
+#include "runmemo.h"
+#include "solver.h"
+#include <QtAlgorithms>
+
+//Entries in the table (40 bytes each), a power of two
+static const int RUN_MEMO_BITS = 12;
+static const int RUN_MEMO_SIZE = 1 << RUN_MEMO_BITS;
+
+RunMemo::RunMemo() {
+    Entry empty = { 0, 0, { 0 } };
+    table.fill(empty, RUN_MEMO_SIZE);
+}
+
+//The key: the sum in 6 bits, the number of cells in 4,
+//and notes 1-9 of each cell in 9
+int RunMemo::findEntry(int sum, int num, const quint16 *masks, quint64 &keyLo, quint64 &keyHi) const {
+    keyLo = quint64(sum) | quint64(num) << 6;
+    keyHi = 0;
+    for (int n = 0; n < num; n++) {
+        int shift = 10 + 9*n;
+        if (shift < 64)
+            keyLo |= quint64(masks[n] >> 1) << shift;
+        else
+            keyHi |= quint64(masks[n] >> 1) << (shift - 64);
+    }
+
+    quint64 hash = (keyLo ^ keyHi*Q_UINT64_C(0x9e3779b97f4a7c15))*Q_UINT64_C(0xbf58476d1ce4e5b9);
+    return int(hash >> (64 - RUN_MEMO_BITS));
+}
+
+bool RunMemo::lookup(int sum, int num, const quint16 *masks, quint16 *allowed) const {
+    quint64 keyLo, keyHi;
+    const Entry &entry = table[findEntry(sum, num, masks, keyLo, keyHi)];
+    if (entry.keyLo != keyLo || entry.keyHi != keyHi)
+        return false;
+    for (int n = 0; n < num; n++) {
+        allowed[n] = entry.allowed[n];
+    }
+    return true;
+}
+
+void RunMemo::insert(int sum, int num, const quint16 *masks, quint16 *allowed) {
+    quint64 keyLo, keyHi;
+    Entry &entry = table[findEntry(sum, num, masks, keyLo, keyHi)];
+    findAllowedNotes(sum, num, masks, allowed);
+    entry.keyLo = keyLo;
+    entry.keyHi = keyHi;
+    for (int n = 0; n < num; n++) {
+        entry.allowed[n] = allowed[n];
+    }
+}
+
+//Tries every way of filling in cells k and on with numbers not in
+//used adding up to sum, adding each number used to allowed. True if
+//there's any way
+static bool fillRunCells(int k, int num, int sum, int used, const quint16 *masks, quint16 *allowed) {
+    if (k == num)
+        return sum == 0;
+
+    //The last cell can only take what's left
+    if (k == num - 1) {
+        int d = sum >= 1 && sum <= 9 ? 1 << sum : 0;
+        if (!(d & masks[k] & ~used))
+            return false;
+        allowed[k] |= quint16(d);
+        return true;
+    }
+
+    bool found = false;
+    for (int m = masks[k] & ~used; m; m &= m - 1) {
+        int d = m & -m;
+        int v = qCountTrailingZeroBits(quint32(d));
+        if (v >= sum)
+            break;
+        if (fillRunCells(k + 1, num, sum - v, used | d, masks, allowed)) {
+            allowed[k] |= quint16(d);
+            found = true;
+        }
+    }
+    return found;
+}
+
+//The notes each cell of a run can keep: the ones it has in some way
+//of filling in the run with different numbers adding up to SUM.
+//For each combo, fwd[s] is whether the first |s| cells can take
+//exactly the numbers in s (one each), and back[s] is whether the
+//rest can take the rest of the combo. A cell can keep a number if
+//the cells before it can take some s without it, and the cells
+//after it can take what's left
+void RunMemo::findAllowedNotes(int sum, int num, const quint16 *masks, quint16 *allowed) {
+    quint8 fwd[1024], back[1024];
+    for (int k = 0; k < num; k++) {
+        allowed[k] = 0;
+    }
+
+    //Short runs have few enough ways to just try them all
+    if (num <= SHORT_RUN_LENGTH) {
+        fillRunCells(0, num, sum, 0, masks, allowed);
+        return;
+    }
+
+    for (int n = 0; n < Solver::getComboCount(sum, num); n++) {
+        int combo = Solver::getComboMask(sum, num, n);
+
+        //No search needed when a cell can't take any of the combo
+        //or a number has no cell, or when every cell can take all of it
+        int covered = 0, whole = combo;
+        bool empty = false;
+        for (int k = 0; k < num; k++) {
+            covered |= masks[k];
+            whole &= masks[k];
+            empty |= !(masks[k] & combo);
+        }
+        if (empty || (covered & combo) != combo)
+            continue;
+        if (whole == combo) {
+            for (int k = 0; k < num; k++) {
+                allowed[k] |= quint16(combo);
+            }
+            continue;
+        }
+
+        //Subsets of the combo, smallest first. Cell k
+        //takes the last number of a subset of k+1
+        int s = 0;
+        do {
+            int k = qPopulationCount(quint16(s)) - 1;
+            fwd[s] = s == 0;
+            for (int d = k >= 0 ? s & masks[k] : 0; d && !fwd[s]; d &= d - 1) {
+                fwd[s] = fwd[s & ~(d & -d)];
+            }
+            s = (s - combo) & combo;
+        } while (s);
+
+        //Biggest first. Cell k takes the next number
+        //after a subset of k
+        s = combo;
+        while (true) {
+            int k = qPopulationCount(quint16(s));
+            back[s] = s == combo;
+            for (int d = k < num ? combo & ~s & masks[k] : 0; d && !back[s]; d &= d - 1) {
+                back[s] = back[s | (d & -d)];
+            }
+
+            if (fwd[s] && k < num) {
+                for (int d = combo & ~s & masks[k]; d; d &= d - 1) {
+                    if (back[s | (d & -d)])
+                        allowed[k] |= quint16(d & -d);
+                }
+            }
+
+            if (!s)
+                break;
+            s = (s - 1) & combo;
+        }
+    }
+}
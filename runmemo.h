@@ -0,0 +1,46 @@
+/*
+ * runmemo.h
+ *
+ * The RunMemo works out which notes the empty cells of a run can
+ * keep, from what they have to add up to and their masks, and
+ * remembers the answers in a small direct-mapped table, since the
+ * same runs come up over and over. The Solver and the BatchSolver
+ * each keep one.
+ */
+
+#ifndef RUNMEMO_H
+#define RUNMEMO_H
+
+#include <QVector>
+
+class RunMemo {
+public:
+    RunMemo();
+
+    //Fills in allowed for NUM cells with the given masks (bits 1-9
+    //only) adding up to SUM, if it's in the table
+    bool lookup(int sum, int num, const quint16 *masks, quint16 *allowed) const;
+    //Works out allowed, and puts it in the table
+    void insert(int sum, int num, const quint16 *masks, quint16 *allowed);
+
+    //The notes each of NUM cells with the given masks can keep,
+    //for the cells to add up to SUM with different numbers
+    static void findAllowedNotes(int sum, int num, const quint16 *masks, quint16 *allowed);
+
+    //Longest run whose notes are found by trying every way to fill it in
+    static const int SHORT_RUN_LENGTH = 4;
+
+private:
+    //The sum, number of cells and masks, packed
+    //into 91 bits. keyLo is 0 if empty
+    struct Entry {
+        quint64 keyLo, keyHi;
+        quint16 allowed[9];
+    };
+
+    int findEntry(int sum, int num, const quint16 *masks, quint64 &keyLo, quint64 &keyHi) const;
+
+    QVector<Entry> table;
+};
+
+#endif
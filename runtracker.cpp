@@ -0,0 +1,145 @@
+/*
+ * runtracker.cpp
+ * See runtracker.h for more information
+ */
+
+#include "runtracker.h"
+#include "solver.h"
+
+RunTracker::RunTracker() {
+    numEmpty = numBadRuns = 0;
+}
+
+void RunTracker::load(const BoardModel &model) {
+    int numCells = model.getNumCells();
+    int numRuns = model.getNumRuns();
+
+    //QVectors are shared, so the topology isn't copied
+    downRun = model.downRun;
+    rightRun = model.rightRun;
+    runFirst = model.runFirst;
+    runStride = model.runStride;
+    runClue = model.runClue;
+    runLength = model.runLength;
+
+    value.fill(0, numCells);
+    runSum.fill(0, numRuns);
+    runFilled.fill(0, numRuns);
+    runRepeats.fill(0, numRuns);
+    runUsed.fill(0, numRuns);
+    digitCount.fill(0, numRuns*10);
+    runBad.fill(true, numRuns);
+
+    numEmpty = 0;
+    for (int i = 0; i < numCells; i++) {
+        if (model.type[i] == NONCLUE)
+            numEmpty++;
+    }
+    numBadRuns = numRuns;
+}
+
+void RunTracker::setValue(int cell, int v) {
+    int old = value[cell];
+    if (v == old || v < 0 || v > 9)
+        return;
+
+    if (old) {
+        if (downRun[cell] != -1)
+            removeFromRun(downRun[cell], old);
+        if (rightRun[cell] != -1)
+            removeFromRun(rightRun[cell], old);
+    }
+    if (v) {
+        if (downRun[cell] != -1)
+            addToRun(downRun[cell], v);
+        if (rightRun[cell] != -1)
+            addToRun(rightRun[cell], v);
+    }
+
+    if (!old)
+        numEmpty--;
+    if (!v)
+        numEmpty++;
+    value[cell] = quint8(v);
+
+    if (downRun[cell] != -1)
+        updateRunBad(downRun[cell]);
+    if (rightRun[cell] != -1)
+        updateRunBad(rightRun[cell]);
+}
+
+bool RunTracker::getRunOverSum(int run) const {
+    //A full run has to hit its sum exactly. Otherwise,
+    //every empty cell still adds at least 1
+    int empty = runLength[run] - runFilled[run];
+    if (!empty)
+        return runSum[run] != runClue[run];
+    return runSum[run] + empty > runClue[run];
+}
+
+bool RunTracker::hasConflict(int cell) const {
+    int v = value[cell];
+    if (!v)
+        return false;
+
+    int runs[2] = { downRun[cell], rightRun[cell] };
+    for (int i = 0; i < 2; i++) {
+        if (runs[i] == -1)
+            continue;
+        if (digitCount[runs[i]*10 + v] > 1 || getRunOverSum(runs[i]))
+            return true;
+    }
+    return false;
+}
+
+quint16 RunTracker::getCandidates(int cell) const {
+    quint16 candidates = 0x3FE;
+    if (downRun[cell] != -1)
+        candidates &= getRunCandidates(downRun[cell]);
+    if (rightRun[cell] != -1)
+        candidates &= getRunCandidates(rightRun[cell]);
+    return candidates;
+}
+
+quint16 RunTracker::getRunCandidates(int run) const {
+    int clue = runClue[run], length = runLength[run];
+    quint16 used = runUsed[run];
+
+    quint16 candidates = 0;
+    for (int n = 0; n < Solver::getComboCount(clue, length); n++) {
+        quint16 combo = Solver::getComboMask(clue, length, n);
+        if ((combo & used) == used)
+            candidates |= combo;
+    }
+    return candidates & ~used;
+}
+
+void RunTracker::addToRun(int run, int v) {
+    quint8 &count = digitCount[run*10 + v];
+    if (count)
+        runRepeats[run]++;
+    count++;
+    runUsed[run] |= quint16(1 << v);
+    runSum[run] += v;
+    runFilled[run]++;
+}
+
+void RunTracker::removeFromRun(int run, int v) {
+    quint8 &count = digitCount[run*10 + v];
+    count--;
+    if (count)
+        runRepeats[run]--;
+    else
+        runUsed[run] &= quint16(~(1 << v));
+    runSum[run] -= v;
+    runFilled[run]--;
+}
+
+void RunTracker::updateRunBad(int run) {
+    bool bad = runFilled[run] != runLength[run] ||
+            runSum[run] != runClue[run] || runRepeats[run];
+    if (bad != bool(runBad[run])) {
+        numBadRuns += bad ? 1 : -1;
+        runBad[run] = bad;
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * runtracker.h
+ *
+ * The RunTracker keeps the state of every run (clue group) of
+ * the board being played: the current sum, which numbers are
+ * used (and how often), and how many cells are filled in.
+ * Changing a cell's value updates only the two runs it's in,
+ * so duplicates, runs over their sum, and whether the whole
+ * board is solved are all known right away.
+ *
+ * It also knows which numbers can still go in an empty cell,
+ * going by the numbers already in its runs (used for auto notes).
+ *
+ * It uses the topology (cell types and runs) of a BoardModel,
+ * and cell indexes are row-major like in the BoardModel.
+ */
+
+#ifndef RUNTRACKER_H
+#define RUNTRACKER_H
+
+#include <QVector>
+#include "boardmodel.h"
+#include "common.h"
+
+class RunTracker {
+public:
+    RunTracker();
+
+    //Takes the model's topology. Every cell starts empty
+    void load(const BoardModel &model);
+
+    //Changes the value of a nonclue cell (0 to empty it)
+    void setValue(int cell, int v);
+
+    //Whether every cell is filled in and every run adds up,
+    //without any repeated numbers
+    bool isSolved() const { return numEmpty == 0 && numBadRuns == 0; }
+    //Whether a cell's value is repeated in one of its runs,
+    //or is in a run that can't add up anymore
+    bool hasConflict(int cell) const;
+    //Mask of the numbers that fit a cell's runs: numbers that
+    //aren't used yet, in a combo that has all the used ones
+    quint16 getCandidates(int cell) const;
+
+    int getValue(int cell) const { return value[cell]; }
+    int getDownRun(int cell) const { return downRun[cell]; }
+    int getRightRun(int cell) const { return rightRun[cell]; }
+    int getRunFirst(int run) const { return runFirst[run]; }
+    int getRunStride(int run) const { return runStride[run]; }
+    int getRunLength(int run) const { return runLength[run]; }
+    int getRunSum(int run) const { return runSum[run]; }
+    quint16 getRunUsed(int run) const { return runUsed[run]; }
+    int getRunFilled(int run) const { return runFilled[run]; }
+    //Whether the run's numbers already go over its sum,
+    //or it is full and doesn't add up
+    bool getRunOverSum(int run) const;
+
+private:
+    void addToRun(int run, int v);
+    void removeFromRun(int run, int v);
+    void updateRunBad(int run);
+    quint16 getRunCandidates(int run) const;
+
+    //Per cell
+    QVector<quint8> value;
+    QVector<int> downRun, rightRun;
+
+    //Topology, per run
+    QVector<int> runFirst, runStride;
+    QVector<int> runClue, runLength;
+
+    //State, per run
+    QVector<int> runSum, runFilled, runRepeats;
+    QVector<quint16> runUsed;
+    //How many times n is used in run i, at i*10 + n
+    QVector<quint8> digitCount;
+    //Runs that aren't full, don't add up, or repeat a number
+    QVector<quint8> runBad;
+
+    //Empty nonclue cells, and bad runs
+    int numEmpty, numBadRuns;
+};
+
+#endif
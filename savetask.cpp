@@ -0,0 +1,54 @@
+/*
+ * savetask.cpp
+ * See savetask.h for more information
+ */
+
+#include "savetask.h"
+#include <QSaveFile>
+#include <QTextStream>
+
+SaveTask::SaveTask(const QString &fileName, const PuzzleBoard::Snapshot &snapshot, quint64 generation) {
+    this->fileName = fileName;
+    this->snapshot = snapshot;
+    this->generation = generation;
+    saved = false;
+
+    setAutoDelete(false);
+}
+
+void SaveTask::start(QThreadPool *pool) {
+    pool->start(this);
+}
+
+void SaveTask::run() {
+    saved = writeFile(fileName, PuzzleBoard::makeKAKString(snapshot), &error);
+
+    //Right away, so a journal that's already in the file
+    //is (almost) never left to be replayed over it
+    if (saved && !journalToRemove.isEmpty())
+        QFile::remove(journalToRemove);
+
+    emit finished();
+}
+
+bool SaveTask::writeFile(const QString &fileName, const QString &text, QString *error) {
+    //QSaveFile writes to a temporary file, and
+    //commit() renames it over the real one
+    QSaveFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Text)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << text;
+    out.flush();
+
+    if (!file.commit()) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+    return true;
+}
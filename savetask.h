@@ -0,0 +1,61 @@
+/*
+ * savetask.h
+ *
+ * A SaveTask makes the KAKString of a board snapshot and writes
+ * it to a file on a QThreadPool thread, so autosaving doesn't hold
+ * up the window. Files are written atomically: to a temporary file
+ * first, which replaces the old file only once it's complete, so
+ * a crash mid-write never leaves a half written save behind.
+ *
+ * It can also be given a journal (see MainWindow) that the saved
+ * file replaces, which is removed as soon as the file is written.
+ *
+ * finished() is emitted on the GUI thread once the file is written
+ * (or couldn't be). The task doesn't delete itself; whoever started
+ * it should deleteLater() it after finished().
+ */
+
+#ifndef SAVETASK_H
+#define SAVETASK_H
+
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include "puzzleboard.h"
+
+class SaveTask : public QObject, public QRunnable {
+    Q_OBJECT
+
+public:
+    //generation is the board's generation when the snapshot was taken
+    SaveTask(const QString &fileName, const PuzzleBoard::Snapshot &snapshot, quint64 generation);
+
+    //Starts the task on pool
+    void start(QThreadPool *pool);
+    //Call before start()
+    void setJournalToRemove(const QString &name) { journalToRemove = name; }
+
+    void run() Q_DECL_OVERRIDE;
+
+    //Writes text to fileName atomically. On failure, returns false
+    //and (if error isn't null) sets error to why
+    static bool writeFile(const QString &fileName, const QString &text, QString *error = 0);
+
+    //Results, valid after finished()
+    QString getFileName() const { return fileName; }
+    quint64 getGeneration() const { return generation; }
+    bool getSaved() const { return saved; }
+    QString getError() const { return error; }
+
+signals:
+    void finished();
+
+private:
+    QString fileName, journalToRemove;
+    PuzzleBoard::Snapshot snapshot;
+    quint64 generation;
+    bool saved;
+    QString error;
+};
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ * solutioncache.cpp
+ * See solutioncache.h for more information
+ */
+
+#include "solutioncache.h"
+#include <QFile>
+#include <QDataStream>
+
+//About a megabyte of solutions
+static const int DEFAULT_CAPACITY = 1 << 20;
+
+static const quint32 CACHE_FILE_MAGIC = 0x4B534331;
+static const quint32 CACHE_FILE_VERSION = 1;
+
+SolutionCache &SolutionCache::get() {
+    static SolutionCache solutionCache;
+    return solutionCache;
+}
+
+SolutionCache::SolutionCache() : cache(DEFAULT_CAPACITY) {
+    hits = misses = 0;
+}
+
+bool SolutionCache::lookup(const CanonicalForm &form, BoardModel &model, SolveStatus &status) {
+    QMutexLocker locker(&mutex);
+
+    const Entry *entry = cache.object(form.getFingerprint());
+    if (!entry || entry->rows != form.getRows() || entry->cols != form.getCols()) {
+        misses++;
+        return false;
+    }
+    hits++;
+
+    status = SolveStatus(entry->status);
+    if (status != SOLVE_SOLVED)
+        return true;
+
+    for (int i = 0; i < model.getNumCells(); i++) {
+        if (model.type[i] == CLUE || (model.fixed[i] && model.value[i]))
+            continue;
+        int v = entry->values[form.toCanonical(i)];
+        model.value[i] = quint8(v);
+        model.mask[i] = quint16(1 << v);
+    }
+    return true;
+}
+
+void SolutionCache::insert(const CanonicalForm &form, const BoardModel &model, SolveStatus status) {
+    if (status != SOLVE_SOLVED && status != SOLVE_UNSOLVABLE)
+        return;
+
+    Entry *entry = new Entry;
+    entry->rows = form.getRows();
+    entry->cols = form.getCols();
+    entry->status = quint8(status);
+    if (status == SOLVE_SOLVED) {
+        entry->values.resize(model.getNumCells());
+        for (int i = 0; i < model.getNumCells(); i++) {
+            entry->values[form.toCanonical(i)] = model.type[i] == CLUE ? 0 : model.value[i];
+        }
+    }
+
+    //An unsolvable puzzle costs a cell
+    QMutexLocker locker(&mutex);
+    cache.insert(form.getFingerprint(), entry, qMax(1, entry->values.size()));
+}
+
+void SolutionCache::setCapacity(int cells) {
+    QMutexLocker locker(&mutex);
+    cache.setMaxCost(cells);
+}
+
+int SolutionCache::getCapacity() const {
+    QMutexLocker locker(&mutex);
+    return cache.maxCost();
+}
+
+int SolutionCache::getNumEntries() const {
+    QMutexLocker locker(&mutex);
+    return cache.size();
+}
+
+int SolutionCache::getHits() const {
+    QMutexLocker locker(&mutex);
+    return hits;
+}
+
+int SolutionCache::getMisses() const {
+    QMutexLocker locker(&mutex);
+    return misses;
+}
+
+void SolutionCache::clear() {
+    QMutexLocker locker(&mutex);
+    cache.clear();
+    hits = misses = 0;
+}
+
+bool SolutionCache::load(const QString &fileName) {
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic, version, count;
+    in >> magic >> version >> count;
+    if (magic != CACHE_FILE_MAGIC || version != CACHE_FILE_VERSION)
+        return false;
+
+    QMutexLocker locker(&mutex);
+    for (quint32 n = 0; n < count && in.status() == QDataStream::Ok; n++) {
+        Fingerprint f;
+        qint32 rows, cols;
+        quint8 status;
+        QByteArray values;
+        in >> f.lo >> f.hi >> rows >> cols >> status >> values;
+
+        //Don't take anything that doesn't fit
+        bool solved = status == SOLVE_SOLVED;
+        if (in.status() != QDataStream::Ok || rows < 0 || cols < 0 ||
+                (!solved && status != SOLVE_UNSOLVABLE) ||
+                values.size() != (solved ? rows*cols : 0))
+            return false;
+
+        Entry *entry = new Entry;
+        entry->rows = rows;
+        entry->cols = cols;
+        entry->status = status;
+        entry->values.resize(values.size());
+        for (int i = 0; i < values.size(); i++) {
+            entry->values[i] = quint8(values[i]);
+            //Nor a digit that can't be in a cell
+            if (entry->values[i] > 9) {
+                delete entry;
+                return false;
+            }
+        }
+        cache.insert(f, entry, qMax(1, entry->values.size()));
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+bool SolutionCache::save(const QString &fileName) const {
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    QMutexLocker locker(&mutex);
+    QList<Fingerprint> keys = cache.keys();
+
+    QDataStream out(&file);
+    out << CACHE_FILE_MAGIC << CACHE_FILE_VERSION << quint32(keys.size());
+    for (int n = 0; n < keys.size(); n++) {
+        const Entry *entry = cache.object(keys[n]);
+        QByteArray values(entry->values.size(), 0);
+        for (int i = 0; i < values.size(); i++) {
+            values[i] = char(entry->values[i]);
+        }
+        out << keys[n].lo << keys[n].hi << qint32(entry->rows) << qint32(entry->cols)
+            << entry->status << values;
+    }
+    return out.status() == QDataStream::Ok;
+}
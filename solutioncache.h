@@ -0,0 +1,72 @@
+/*
+ * solutioncache.h
+ *
+ * The SolutionCache remembers how solving a puzzle ended, keyed by
+ * the Fingerprint of the puzzle's CanonicalForm, so solving or
+ * checking a puzzle that's been solved before (or its transpose)
+ * is a lookup instead of a search.
+ *
+ * Only answers that don't depend on limits or on using brute force
+ * are kept: a solution, or that the puzzle can't be solved.
+ * Solutions are stored in canonical order, and mapped back onto
+ * the board they're looked up for.
+ *
+ * It's bounded by the total number of cells of its solutions, and
+ * drops the least recently used ones to make room. It can be saved
+ * to a file and loaded back, though the order of use isn't kept.
+ *
+ * There's one cache, shared by the board and the solve tasks,
+ * so every call locks it.
+ */
+
+#ifndef SOLUTIONCACHE_H
+#define SOLUTIONCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include "fingerprint.h"
+#include "boardmodel.h"
+#include "common.h"
+
+class SolutionCache {
+public:
+    static SolutionCache &get();
+
+    //Looks up the puzzle of form. On a hit, status says whether it
+    //was solved, and if it was, model (which must be the board form
+    //was made from) gets the solution
+    bool lookup(const CanonicalForm &form, BoardModel &model, SolveStatus &status);
+    //Remembers how solving the puzzle of form ended, with
+    //model holding the solution if there is one
+    void insert(const CanonicalForm &form, const BoardModel &model, SolveStatus status);
+
+    //Most cells the solutions can have in total
+    void setCapacity(int cells);
+    int getCapacity() const;
+    int getNumEntries() const;
+    int getHits() const;
+    int getMisses() const;
+    void clear();
+
+    //Loading adds to what's already in the cache
+    bool load(const QString &fileName);
+    bool save(const QString &fileName) const;
+
+private:
+    SolutionCache();
+
+    struct Entry {
+        //Of the canonical board
+        int rows, cols;
+        quint8 status;
+        //Canonical order, 0 for clues. Empty if unsolvable
+        QVector<quint8> values;
+    };
+
+    mutable QMutex mutex;
+    QCache<Fingerprint, Entry> cache;
+    int hits, misses;
+};
+
+#endif
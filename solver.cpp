@@ -0,0 +1,938 @@
+/*
+ * solver.cpp
+ * See solver.h for more information
+ */
+
+#include "solver.h"
+#include <QtAlgorithms>
+#include <QElapsedTimer>
+
+//Most cell changes the step log keeps (12 bytes each)
+static const int MAX_SOLVE_STEPS = 1 << 20;
+
+//Mask helpers
+static inline quint16 digitBit(int v) {
+    return quint16(1 << v);
+}
+
+static inline int countNotes(quint16 mask) {
+    return qPopulationCount(mask);
+}
+
+static inline int lowestNote(quint16 mask) {
+    return mask ? qCountTrailingZeroBits(mask) : 10;
+}
+
+static inline int highestNote(quint16 mask) {
+    return mask ? 15 - qCountLeadingZeroBits(mask) : 0;
+}
+
+//Mask of the digits from lo to hi, clipped to 1-9
+static inline quint16 rangeMask(int lo, int hi) {
+    if (lo < 1) lo = 1;
+    if (hi > 9) hi = 9;
+    if (lo > hi)
+        return 0;
+    return quint16(((1 << (hi+1)) - 1) & ~((1 << lo) - 1));
+}
+
+//Every combination of digits making SUM in NUM cells, as masks.
+//There are never more than 12 for any SUM and NUM.
+struct ComboTable {
+    quint16 masks[46][10][12];
+    int count[46][10];
+
+    ComboTable() {
+        for (int SUM = 0; SUM <= 45; SUM++) {
+            for (int NUM = 0; NUM <= 9; NUM++) {
+                count[SUM][NUM] = 0;
+            }
+        }
+        //Masks are built from bits 1-9, so go through every one
+        for (int m = 2; m < 1024; m += 2) {
+            int sum = 0;
+            for (int n = 1; n < 10; n++) {
+                if (m & (1 << n))
+                    sum += n;
+            }
+            int num = countNotes(quint16(m));
+            masks[sum][num][count[sum][num]++] = quint16(m);
+        }
+    }
+};
+
+static const ComboTable &comboTable() {
+    static const ComboTable table;
+    return table;
+}
+
+int Solver::getComboCount(int sum, int num) {
+    if (sum < 0 || sum > 45 || num < 0 || num > 9)
+        return 0;
+    return comboTable().count[sum][num];
+}
+
+quint16 Solver::getComboMask(int sum, int num, int i) {
+    return comboTable().masks[sum][num][i];
+}
+
+//Union of the combos still possible for a run
+static inline quint16 comboUnion(int sum, int num, quint16 combos) {
+    quint16 u = 0;
+    for (int i = 0; combos; i++, combos >>= 1) {
+        if (combos & 1)
+            u |= Solver::getComboMask(sum, num, i);
+    }
+    return u;
+}
+
+//The hint for a number placed by rule, if it's one a hint can give
+static HintRule getHintRule(SolveRule rule) {
+    switch (rule) {
+    case RULE_LAST_IN_RUN:
+        return HINT_LAST_IN_RUN;
+    case RULE_ONLY_PLACE:
+        return HINT_ONLY_PLACE;
+    case RULE_ONE_NOTE:
+        return HINT_ONE_NOTE;
+    default:
+        return HINT_NONE;
+    }
+}
+
+SolverArena::SolverArena() {
+    block = 0;
+    capacity = offset = 0;
+    failed = false;
+}
+
+SolverArena::~SolverArena() {
+    delete [] block;
+}
+
+void SolverArena::reserve(int bytes) {
+    offset = 0;
+    failed = false;
+    if (bytes <= capacity)
+        return;
+    delete [] block;
+    block = new char[bytes];
+    capacity = bytes;
+}
+
+Solver::Solver() {
+    rows = cols = 0;
+    numCells = numRuns = 0;
+    type = fixed = 0;
+    downRun = rightRun = 0;
+    runFirst = runStride = 0;
+    runClue = runLength = 0;
+    value = 0;
+    mask = 0;
+    runCombos = 0;
+    runQueued = 0;
+    queue = 0;
+    queueHead = queueSize = 0;
+    trail = 0;
+    trailSize = trailCapacity = 0;
+    frames = 0;
+    frameCapacity = 0;
+    overflowed = false;
+    stats = { 0, 0, 0, 0, 0, 0 };
+    traceEnabled = false;
+    stepLogEnabled = stepLogging = false;
+    rule = RULE_START;
+    hinting = false;
+    hint = { { -1, -1 }, 0, HINT_NONE };
+    status = SOLVE_UNFINISHED;
+    token = 0;
+    limits = { 0, 0 };
+}
+
+void Solver::load(const BoardModel &model) {
+    rows = model.rows;
+    cols = model.cols;
+    numCells = model.getNumCells();
+    numRuns = model.getNumRuns();
+
+    type = model.type.constData();
+    fixed = model.fixed.constData();
+    downRun = model.downRun.constData();
+    rightRun = model.rightRun.constData();
+    runFirst = model.runFirst.constData();
+    runStride = model.runStride.constData();
+    runClue = model.runClue.constData();
+    runLength = model.runLength.constData();
+
+    int nonClues = 0;
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == NONCLUE)
+            nonClues++;
+    }
+
+    //A cell's mask/value can only change 10 times along one search
+    //path, and a run can lose each of its (at most 12) combos once
+    trailCapacity = 10*nonClues + 12*numRuns;
+    frameCapacity = nonClues + 1;
+
+    arena.reserve(numCells*int(sizeof(quint8)) +
+                  numCells*int(sizeof(quint16)) +
+                  numRuns*int(sizeof(quint16)) +
+                  numRuns*int(sizeof(quint8)) +
+                  numRuns*int(sizeof(int)) +
+                  trailCapacity*int(sizeof(TrailEntry)) +
+                  frameCapacity*int(sizeof(SearchFrame)) +
+                  7*SolverArena::ALIGNMENT);
+    value = arena.alloc<quint8>(numCells);
+    mask = arena.alloc<quint16>(numCells);
+    runCombos = arena.alloc<quint16>(numRuns);
+    runQueued = arena.alloc<quint8>(numRuns);
+    queue = arena.alloc<int>(numRuns);
+    trail = arena.alloc<TrailEntry>(trailCapacity);
+    frames = arena.alloc<SearchFrame>(frameCapacity);
+    queueHead = queueSize = 0;
+    trailSize = 0;
+    overflowed = false;
+
+    //Nothing to work on; solve() reports it
+    if (arena.hasFailed()) {
+        numCells = numRuns = 0;
+        trailCapacity = frameCapacity = 0;
+        return;
+    }
+
+    //Impossible clues get no combos at all
+    for (int run = 0; run < numRuns; run++) {
+        runCombos[run] = quint16((1 << getComboCount(runClue[run], runLength[run])) - 1);
+        runQueued[run] = false;
+    }
+
+    //Start nonfixed cells off with the intersection
+    //of their down and right combos
+    for (int i = 0; i < numCells; i++) {
+        value[i] = 0;
+        mask[i] = 0;
+        if (type[i] == CLUE)
+            continue;
+
+        if (fixed[i] && model.value[i]) {
+            value[i] = model.value[i];
+            mask[i] = digitBit(value[i]);
+            continue;
+        }
+
+        mask[i] = rangeMask(1, 9);
+        if (downRun[i] != -1) {
+            int run = downRun[i];
+            mask[i] &= comboUnion(runClue[run], runLength[run], runCombos[run]);
+        }
+        if (rightRun[i] != -1) {
+            int run = rightRun[i];
+            mask[i] &= comboUnion(runClue[run], runLength[run], runCombos[run]);
+        }
+    }
+}
+
+void Solver::store(BoardModel &model) const {
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == CLUE || (fixed[i] && value[i]))
+            continue;
+        model.value[i] = value[i];
+        model.mask[i] = mask[i];
+    }
+}
+
+bool Solver::solve(bool useBruteForce) {
+    stats = { 0, 0, 0, 0, 0, 0 };
+    trace.clear();
+    status = SOLVE_UNSOLVABLE;
+    overflowed = false;
+    solveTimer.start();
+    if (arena.hasFailed()) {
+        status = SOLVE_OVERFLOWED;
+        return false;
+    }
+
+    //The log starts with the notes load() gave the cells
+    steps.clear();
+    stepLogging = stepLogEnabled;
+    if (stepLogging) {
+        for (int i = 0; i < numCells; i++) {
+            if (type[i] == NONCLUE && !fixed[i])
+                steps.push_back({ i, 0, mask[i], 0, 0, RULE_START });
+        }
+    }
+
+    //Remove the fixed values from their neighbors' notes
+    rule = RULE_PEERS;
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == CLUE || !fixed[i] || !value[i])
+            continue;
+        if (!eliminateFromPeers(i, value[i])) {
+            clearQueue();
+            if (overflowed)
+                status = SOLVE_OVERFLOWED;
+            return false;
+        }
+    }
+
+    //Do as much as we can with logic
+    for (int run = 0; run < numRuns; run++) {
+        enqueue(run);
+    }
+    if (!propagate(false)) {
+        if (overflowed)
+            status = SOLVE_OVERFLOWED;
+        return false;
+    }
+
+    int minNotes;
+    if (pickGuessCell(minNotes) == -1) {
+        if (isSolution())
+            status = SOLVE_SOLVED;
+        return status == SOLVE_SOLVED;
+    }
+
+    //Smart bruteforce
+    if (!useBruteForce) {
+        status = SOLVE_UNFINISHED;
+        return false;
+    }
+    return search();
+}
+
+SolveHint Solver::findHint(const BoardModel &model) {
+    load(model);
+    hint = { { -1, -1 }, 0, HINT_NONE };
+    stepLogging = false;
+    rule = RULE_PEERS;
+    SolveHint mistake = { { -1, -1 }, 0, HINT_MISTAKE };
+
+    //Remove the fixed values from their neighbors' notes
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == CLUE || !fixed[i] || !value[i])
+            continue;
+        if (!eliminateFromPeers(i, value[i])) {
+            clearQueue();
+            return mistake;
+        }
+    }
+
+    //Take the player's numbers, then their notes, as given
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == CLUE || fixed[i] || !model.value[i])
+            continue;
+        if (!place(i, model.value[i])) {
+            clearQueue();
+            mistake.cell = { i/cols, i%cols };
+            mistake.digit = model.value[i];
+            return mistake;
+        }
+    }
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == CLUE || value[i] || !model.mask[i])
+            continue;
+        if (!restrict(i, model.mask[i])) {
+            clearQueue();
+            mistake.cell = { i/cols, i%cols };
+            return mistake;
+        }
+    }
+
+    //Try the simple rules everywhere before the harder ones
+    hinting = true;
+    for (int run = 0; run < numRuns; run++) {
+        enqueue(run);
+    }
+    bool consistent = propagate(true);
+    if (consistent && hint.rule == HINT_NONE) {
+        for (int run = 0; run < numRuns; run++) {
+            enqueue(run);
+        }
+        consistent = propagate(false);
+    }
+    hinting = false;
+
+    //A rule ran into a contradiction, but it's
+    //not clear which of the player's cells caused it
+    if (!consistent)
+        return mistake;
+    return hint;
+}
+
+bool Solver::setCell(int cell, quint16 newMask, int newValue) {
+    //Checked in release builds too, since writing
+    //past the trail would corrupt the arena
+    if (trailSize == trailCapacity) {
+        overflowed = true;
+        return false;
+    }
+    if (stepLogging)
+        logStep(cell, newMask, newValue, rule);
+
+    trail[trailSize].index = cell;
+    trail[trailSize].oldMask = mask[cell];
+    trail[trailSize].oldValue = value[cell];
+    trailSize++;
+
+    mask[cell] = newMask;
+    value[cell] = quint8(newValue);
+
+    if (downRun[cell] != -1)
+        enqueue(downRun[cell]);
+    if (rightRun[cell] != -1)
+        enqueue(rightRun[cell]);
+    return true;
+}
+
+void Solver::logStep(int cell, quint16 newMask, int newValue, SolveRule stepRule) {
+    //A log that's too long to replay isn't worth keeping
+    if (steps.size() >= MAX_SOLVE_STEPS) {
+        steps.clear();
+        steps.squeeze();
+        stepLogging = false;
+        return;
+    }
+    steps.push_back({ cell, mask[cell], newMask, value[cell], quint8(newValue), quint8(stepRule) });
+}
+
+bool Solver::setRunCombos(int run, quint16 combos) {
+    if (trailSize == trailCapacity) {
+        overflowed = true;
+        return false;
+    }
+    trail[trailSize].index = -run-1;
+    trail[trailSize].oldMask = runCombos[run];
+    trail[trailSize].oldValue = 0;
+    trailSize++;
+
+    runCombos[run] = combos;
+    return true;
+}
+
+bool Solver::place(int cell, int v) {
+    if (value[cell])
+        return value[cell] == v;
+    if (!(mask[cell] & digitBit(v)))
+        return false;
+
+    if (hinting && hint.rule == HINT_NONE)
+        hint = { { cell/cols, cell%cols }, v, getHintRule(rule) };
+
+    if (!setCell(cell, digitBit(v), v))
+        return false;
+
+    SolveRule placedBy = rule;
+    rule = RULE_PEERS;
+    bool possible = eliminateFromPeers(cell, v);
+    rule = placedBy;
+    return possible;
+}
+
+bool Solver::eliminateFromPeers(int cell, int v) {
+    const int cellRuns[2] = { downRun[cell], rightRun[cell] };
+    for (int dir = 0; dir < 2; dir++) {
+        int run = cellRuns[dir];
+        if (run == -1)
+            continue;
+        int stride = runStride[run], length = runLength[run];
+        for (int k = 0, i = runFirst[run]; k < length; k++, i += stride) {
+            if (i == cell)
+                continue;
+            if (!restrict(i, quint16(~digitBit(v))))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Solver::restrict(int cell, quint16 allowed) {
+    quint16 newMask = mask[cell] & allowed;
+    if (newMask == mask[cell])
+        return true;
+    //A solved cell losing its value ends up with an empty mask
+    return setCell(cell, newMask, value[cell]) && newMask != 0;
+}
+
+void Solver::undoTo(int mark) {
+    while (trailSize > mark) {
+        trailSize--;
+        const TrailEntry &entry = trail[trailSize];
+        if (entry.index >= 0) {
+            if (stepLogging)
+                logStep(entry.index, entry.oldMask, entry.oldValue, RULE_UNDO);
+            mask[entry.index] = entry.oldMask;
+            value[entry.index] = entry.oldValue;
+        }
+        else {
+            runCombos[-entry.index-1] = entry.oldMask;
+        }
+    }
+    //Everything up to the mark was already propagated
+    clearQueue();
+}
+
+void Solver::enqueue(int run) {
+    if (runQueued[run])
+        return;
+    runQueued[run] = true;
+    queue[(queueHead + queueSize) % numRuns] = run;
+    queueSize++;
+}
+
+void Solver::clearQueue() {
+    while (queueSize) {
+        runQueued[queue[queueHead]] = false;
+        queueHead = (queueHead + 1) % numRuns;
+        queueSize--;
+    }
+}
+
+bool Solver::propagate(bool lazy) {
+    while (queueSize) {
+        int run = queue[queueHead];
+        queueHead = (queueHead + 1) % numRuns;
+        queueSize--;
+        runQueued[run] = false;
+
+        if (!processRun(run, lazy)) {
+            clearQueue();
+            return false;
+        }
+        //A hint only needs the first number placed
+        if (hinting && hint.rule != HINT_NONE) {
+            clearQueue();
+            return true;
+        }
+    }
+    return true;
+}
+
+bool Solver::processRun(int run, bool lazy) {
+    if (!pruneRunCombos(run))
+        return false;
+    rule = RULE_RANGE;
+    if (!adjustRunByRange(run))
+        return false;
+    rule = RULE_LAST_IN_RUN;
+    if (!solveRunUniqueWithOneEmpty(run))
+        return false;
+    //Memoized, so cheap enough for search too. It isn't
+    //one of the simple rules a hint tries first, though
+    if (!lazy || !hinting) {
+        rule = RULE_COMBOS;
+        if (!filterRunByCombos(run, lazy))
+            return false;
+    }
+    if (!lazy) {
+        rule = RULE_ONLY_PLACE;
+        if (!solveRunNecessaryValues(run))
+            return false;
+        rule = RULE_NAKED_SUBSET;
+        if (!removeRunNakedSubsets(run))
+            return false;
+    }
+    rule = RULE_ONE_NOTE;
+    return solveRunCellsWithOneNote(run);
+}
+
+bool Solver::pruneRunCombos(int run) {
+    int first = runFirst[run], stride = runStride[run];
+    int clue = runClue[run], length = runLength[run];
+
+    quint16 solved = 0;
+    for (int k = 0, i = first; k < length; k++, i += stride) {
+        solved |= digitBit(value[i]);
+    }
+    solved &= ~digitBit(0);
+
+    //Delete the combos that don't include every solved number,
+    //or that don't have any of an unsolved cell's notes
+    quint16 combos = runCombos[run];
+    for (int n = 0; n < 12; n++) {
+        if (!(combos & (1 << n)))
+            continue;
+        quint16 combo = getComboMask(clue, length, n);
+        bool possible = (combo & solved) == solved;
+        for (int k = 0, i = first; possible && k < length; k++, i += stride) {
+            if (!value[i] && !(mask[i] & combo))
+                possible = false;
+        }
+        if (!possible)
+            combos &= ~(1 << n);
+    }
+
+    if (combos != runCombos[run] && !setRunCombos(run, combos))
+        return false;
+    return combos != 0;
+}
+
+bool Solver::adjustRunByRange(int run) {
+    int first = runFirst[run], stride = runStride[run];
+    int clue = runClue[run], length = runLength[run];
+
+    //Remove all notes less than the clue - (sum of the
+    //other cells' max notes), and all notes higher than
+    //the clue - (sum of the other cells' min notes)
+    int minNoteSum = 0, maxNoteSum = 0;
+    for (int k = 0, i = first; k < length; k++, i += stride) {
+        minNoteSum += lowestNote(mask[i]);
+        maxNoteSum += highestNote(mask[i]);
+    }
+
+    for (int k = 0, i = first; k < length; k++, i += stride) {
+        if (value[i])
+            continue;
+        int cellMin = clue - (maxNoteSum - highestNote(mask[i]));
+        int cellMax = clue - (minNoteSum - lowestNote(mask[i]));
+        if (!restrict(i, rangeMask(cellMin, cellMax)))
+            return false;
+    }
+    return true;
+}
+
+bool Solver::solveRunUniqueWithOneEmpty(int run) {
+    if (countNotes(runCombos[run]) != 1)
+        return true;
+
+    int first = runFirst[run], stride = runStride[run];
+    int clue = runClue[run], length = runLength[run];
+
+    //Is there only a single empty cell?
+    quint16 numsLeft = getComboMask(clue, length, lowestNote(runCombos[run]));
+    int unsolvedCell = -1;
+    for (int k = 0, i = first; k < length; k++, i += stride) {
+        if (value[i]) {
+            numsLeft &= ~digitBit(value[i]);
+        }
+        else {
+            if (unsolvedCell != -1)
+                return true;
+            unsolvedCell = i;
+        }
+    }
+
+    if (unsolvedCell != -1 && countNotes(numsLeft) == 1)
+        return place(unsolvedCell, lowestNote(numsLeft));
+    return true;
+}
+
+bool Solver::filterRunByCombos(int run, bool lazy) {
+    int first = runFirst[run], stride = runStride[run];
+    int length = runLength[run];
+
+    //If a note isn't in any way of filling in the run, remove it
+    quint16 allowed[9];
+    if (findRunAllowedNotes(run, allowed, lazy)) {
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            if (value[i])
+                continue;
+            if (!restrict(i, allowed[k]))
+                return false;
+        }
+        return true;
+    }
+    if (lazy)
+        return true;
+
+    //Runs that can't be memoized only go by the possible combos
+    quint16 possible = comboUnion(runClue[run], length, runCombos[run]);
+    for (int k = 0, i = first; k < length; k++, i += stride) {
+        if (value[i])
+            continue;
+        if (!restrict(i, possible))
+            return false;
+    }
+    return true;
+}
+
+bool Solver::findRunAllowedNotes(int run, quint16 *allowed, bool lazy) {
+    int first = runFirst[run], stride = runStride[run];
+    int clue = runClue[run], length = runLength[run];
+    if (clue < 1 || clue > 45 || length < 1 || length > 9)
+        return false;
+
+    //Solved cells are taken out, so runs that only differ
+    //in them share an entry: what's left has to add up to
+    //the rest of the clue, without the numbers they have
+    quint16 masks[9], solved = 0;
+    int cells[9], sum = clue, num = 0;
+    for (int k = 0, i = first; k < length; k++, i += stride) {
+        allowed[k] = digitBit(value[i]);
+        if (value[i]) {
+            sum -= value[i];
+            solved |= digitBit(value[i]);
+        }
+        else {
+            cells[num] = k;
+            masks[num++] = quint16(mask[i] & rangeMask(1, 9));
+        }
+    }
+    if (!num)
+        return true;
+    if (sum < 1) {
+        for (int n = 0; n < num; n++) {
+            allowed[cells[n]] = 0;
+        }
+        return true;
+    }
+
+    for (int n = 0; n < num; n++) {
+        masks[n] &= ~solved;
+    }
+
+    quint16 found[9];
+    if (runMemo.lookup(sum, num, masks, found)) {
+        stats.memoHits++;
+    }
+    else {
+        stats.memoMisses++;
+        //A guess can't wait on working out a long run
+        if (lazy && num > RunMemo::SHORT_RUN_LENGTH)
+            return false;
+        runMemo.insert(sum, num, masks, found);
+    }
+
+    for (int n = 0; n < num; n++) {
+        allowed[cells[n]] = found[n];
+    }
+    return true;
+}
+
+bool Solver::solveRunNecessaryValues(int run) {
+    int first = runFirst[run], stride = runStride[run];
+    int clue = runClue[run], length = runLength[run];
+
+    //Figure out which numbers are in every combo
+    quint16 necessary = rangeMask(1, 9);
+    for (int n = 0; n < 12; n++) {
+        if (runCombos[run] & (1 << n))
+            necessary &= getComboMask(clue, length, n);
+    }
+
+    //Set cells that are the only ones with necessary values
+    for (int v = 1; v < 10; v++) {
+        if (!(necessary & digitBit(v)))
+            continue;
+
+        int timesSeen = 0, cell = -1;
+        bool solved = false;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            if (value[i] == v)
+                solved = true;
+            if (!value[i] && (mask[i] & digitBit(v))) {
+                timesSeen++;
+                cell = i;
+            }
+        }
+        if (solved)
+            continue;
+        //A necessary value with nowhere to go
+        if (timesSeen == 0)
+            return false;
+        if (timesSeen == 1 && !place(cell, v))
+            return false;
+    }
+    return true;
+}
+
+bool Solver::removeRunNakedSubsets(int run) {
+    if (countNotes(runCombos[run]) != 1)
+        return true;
+
+    int first = runFirst[run], stride = runStride[run];
+    int length = runLength[run];
+
+    //If there was ever a case where there were N
+    //cells with ONLY the same N notes, we can safely
+    //remove those notes from other cells
+    for (int k = 0, i = first; k < length; k++, i += stride) {
+        quint16 subset = mask[i];
+        if (value[i] || countNotes(subset) < 2)
+            continue;
+
+        int count = 0;
+        for (int k2 = 0, i2 = first; k2 < length; k2++, i2 += stride) {
+            if (!value[i2] && mask[i2] == subset)
+                count++;
+        }
+        if (count > countNotes(subset))
+            return false;
+        if (count < countNotes(subset))
+            continue;
+
+        for (int k2 = 0, i2 = first; k2 < length; k2++, i2 += stride) {
+            if (value[i2] || mask[i2] == subset)
+                continue;
+            if (!restrict(i2, quint16(~subset)))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Solver::solveRunCellsWithOneNote(int run) {
+    int first = runFirst[run], stride = runStride[run];
+    int length = runLength[run];
+
+    for (int k = 0, i = first; k < length; k++, i += stride) {
+        if (value[i] || countNotes(mask[i]) != 1)
+            continue;
+        if (!place(i, lowestNote(mask[i])))
+            return false;
+    }
+    return true;
+}
+
+bool Solver::shouldStop() {
+    if (overflowed) {
+        status = SOLVE_OVERFLOWED;
+        return true;
+    }
+    if (token && token->isCancelled()) {
+        status = SOLVE_CANCELLED;
+        return true;
+    }
+    if (limits.maxNodes && stats.nodes >= limits.maxNodes) {
+        status = SOLVE_OUT_OF_NODES;
+        return true;
+    }
+    if (limits.timeLimitMsecs && solveTimer.hasExpired(limits.timeLimitMsecs)) {
+        status = SOLVE_TIMED_OUT;
+        return true;
+    }
+    return false;
+}
+
+int Solver::pickGuessCell(int &minNotes) const {
+    //Pick empty nonclue cell with lowest number of notes
+    int cell = -1;
+    minNotes = 10;
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == CLUE || value[i])
+            continue;
+        int noteCount = countNotes(mask[i]);
+        if (noteCount < minNotes) {
+            minNotes = noteCount;
+            cell = i;
+            //Can't get a lower number of notes, so stop
+            if (minNotes == 0)
+                break;
+        }
+    }
+    return cell;
+}
+
+bool Solver::isSolution() const {
+    for (int i = 0; i < numCells; i++) {
+        if (type[i] == NONCLUE && !value[i])
+            return false;
+    }
+    for (int run = 0; run < numRuns; run++) {
+        int first = runFirst[run], stride = runStride[run];
+        int length = runLength[run];
+
+        int sum = 0;
+        quint16 used = 0;
+        for (int k = 0, i = first; k < length; k++, i += stride) {
+            //Can't repeat numbers
+            if (used & digitBit(value[i]))
+                return false;
+            used |= digitBit(value[i]);
+            sum += value[i];
+        }
+        if (sum != runClue[run])
+            return false;
+    }
+    return true;
+}
+
+bool Solver::search() {
+    int minNotes;
+    int cell = pickGuessCell(minNotes);
+    if (cell == -1) {
+        if (isSolution())
+            status = SOLVE_SOLVED;
+        return status == SOLVE_SOLVED;
+    }
+    if (minNotes == 0)
+        return false;
+
+    int depth = 0;
+    frames[0] = { cell, trailSize, -1, 1, false };
+    stats.nodes = 1;
+    stats.maxDepth = 1;
+
+    while (depth >= 0) {
+        //Put the board back to what logic got before stopping
+        if (shouldStop()) {
+            undoTo(frames[0].trailMark);
+            return false;
+        }
+
+        SearchFrame &frame = frames[depth];
+
+        //Undo the previous guess, since it didn't work
+        if (frame.guessed) {
+            stats.backtracks++;
+            QElapsedTimer restoreTimer;
+            restoreTimer.start();
+            undoTo(frame.trailMark);
+            stats.restoreNsecs += restoreTimer.nsecsElapsed();
+            frame.guessed = false;
+        }
+
+        //Loop through the notes of the cell we picked
+        int v = frame.nextDigit;
+        while (v < 10 && !(mask[frame.cell] & digitBit(v)))
+            v++;
+        if (v == 10) {
+            depth--;
+            continue;
+        }
+        frame.nextDigit = v+1;
+        frame.guessed = true;
+
+        if (traceEnabled) {
+            frame.traceIndex = trace.size();
+            trace.push_back({ depth+1, { frame.cell/cols, frame.cell%cols }, v, GUESS_FAILED });
+        }
+
+        //Try a note on the cell we picked
+        rule = RULE_GUESS;
+        if (!place(frame.cell, v) || !propagate(true))
+            continue;
+
+        int next = pickGuessCell(minNotes);
+        if (next == -1) {
+            if (!isSolution())
+                continue;
+            //Every guess still on the stack led to the solution
+            if (traceEnabled) {
+                for (int d = 0; d <= depth; d++) {
+                    trace[frames[d].traceIndex].outcome = GUESS_SOLVED;
+                }
+            }
+            status = SOLVE_SOLVED;
+            return true;
+        }
+        if (minNotes == 0)
+            continue;
+
+        //Can't go deeper than there are cells, but
+        //don't trust that with the arena
+        if (depth+1 == frameCapacity) {
+            overflowed = true;
+            continue;
+        }
+        depth++;
+        frames[depth] = { next, trailSize, -1, 1, false };
+        stats.nodes++;
+        if (token && stats.nodes%1024 == 0)
+            token->setProgress(stats.nodes);
+        if (depth+1 > stats.maxDepth)
+            stats.maxDepth = depth+1;
+    }
+
+    return false;
+}
@@ -0,0 +1,225 @@
+/*
+ * solver.h
+ *
+ * The Solver class holds the logic and brute force solving
+ * used by PuzzleBoard. It works on a BoardModel: candidate masks
+ * (bit n is set if n is still possible for a cell) and runs, each
+ * with a mask of which of its sumInNum combos are still possible.
+ * Its working memory comes from a SolverArena, sized when a
+ * model is loaded.
+ */
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <QVector>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include "boardmodel.h"
+#include "runmemo.h"
+#include "common.h"
+
+class SolverArena {
+public:
+    SolverArena();
+    ~SolverArena();
+
+    //Makes room for at least bytes, and frees everything given out
+    void reserve(int bytes);
+    //Frees everything given out, keeping the memory
+    void reset() { offset = 0; failed = false; }
+
+    //Gives out memory for n Ts. Everything is aligned to
+    //ALIGNMENT bytes, so reserve ALIGNMENT extra per alloc.
+    //Returns 0 if it doesn't fit, and so does every alloc
+    //after that until the next reserve() or reset()
+    template <typename T> T *alloc(int n);
+
+    int getUsed() const { return offset; }
+    int getCapacity() const { return capacity; }
+    //Whether an alloc didn't fit, which is a sizing bug
+    bool hasFailed() const { return failed; }
+
+    static const int ALIGNMENT = 32;
+
+private:
+    SolverArena(const SolverArena &);
+    SolverArena &operator=(const SolverArena &);
+
+    char *block;
+    int capacity, offset;
+    bool failed;
+};
+
+template <typename T>
+T *SolverArena::alloc(int n) {
+    int start = (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    int bytes = n*int(sizeof(T));
+    //The arena is sized up front, so running out is a sizing bug.
+    //Checked in release builds too, rather than writing past it
+    if (failed || n < 0 || start + bytes > capacity) {
+        failed = true;
+        return 0;
+    }
+    offset = start + bytes;
+    return reinterpret_cast<T *>(block + start);
+}
+
+//Lets another thread stop a solve (or generate) early,
+//and see how far along it is
+class CancelToken {
+public:
+    CancelToken() : cancelled(0), progress(0) {}
+
+    void cancel() { cancelled.storeRelease(1); }
+    bool isCancelled() const { return cancelled.loadAcquire(); }
+
+    void setProgress(int p) { progress.storeRelease(p); }
+    int getProgress() const { return progress.loadAcquire(); }
+
+private:
+    QAtomicInt cancelled, progress;
+};
+
+class Solver {
+public:
+    Solver();
+
+    //Sizes the arena from the model's topology and loads its cells.
+    //Nonfixed nonclue cells start out with every candidate their
+    //clues allow. The model's topology is used in place, so it
+    //must not change while the Solver is using it.
+    void load(const BoardModel &model);
+    //Writes values and candidates back into the model
+    void store(BoardModel &model) const;
+
+    //Solves with logic, then (if allowed) with brute force.
+    //getStatus() says why it returned false. If brute force is
+    //stopped early, the cells are left as logic got them
+    bool solve(bool useBruteForce = true);
+    SolveStatus getStatus() const { return status; }
+
+    //Finds the next number the rules can place, starting from the
+    //model's values and notes (as the player has them) instead of
+    //an empty board. Never guesses, and doesn't change the model
+    SolveHint findHint(const BoardModel &model);
+
+    //Search statistics and trace of the last solve
+    SolveStats getStats() const { return stats; }
+    const QVector<SolveTraceEntry> &getTrace() const { return trace; }
+    void setTraceEnabled(bool t) { traceEnabled = t; }
+    //Every cell change of the last solve, in order. Empty if the
+    //log was off, or if the solve made too many changes to keep
+    const QVector<SolveStep> &getSteps() const { return steps; }
+    void setStepLogEnabled(bool s) { stepLogEnabled = s; }
+    //Brute force checks the token and limits at every guess,
+    //and reports guesses to the token
+    void setCancelToken(CancelToken *t) { token = t; }
+    void setLimits(const SolveLimits &l) { limits = l; }
+
+    //Combinations of digits making SUM in NUM cells, as masks
+    static int getComboCount(int sum, int num);
+    static quint16 getComboMask(int sum, int num, int i);
+
+private:
+    struct TrailEntry {
+        //Cell index, or -(run index)-1 for a run's combos
+        int index;
+        quint16 oldMask;
+        quint8 oldValue;
+    };
+
+    struct SearchFrame {
+        int cell;
+        int trailMark;
+        int traceIndex;
+        int nextDigit;
+        bool guessed;
+    };
+
+    //Changing state (all changes go through these). They
+    //return false if the trail is full, and set overflowed
+    bool setCell(int cell, quint16 mask, int value);
+    void logStep(int cell, quint16 newMask, int newValue, SolveRule stepRule);
+    bool setRunCombos(int run, quint16 combos);
+    bool place(int cell, int v);
+    bool eliminateFromPeers(int cell, int v);
+    bool restrict(int cell, quint16 allowed);
+    void undoTo(int mark);
+
+    //Rules. These return false if they run into a contradiction
+    void enqueue(int run);
+    void clearQueue();
+    bool propagate(bool lazy);
+    bool processRun(int run, bool lazy);
+    bool pruneRunCombos(int run);
+    bool adjustRunByRange(int run);
+    bool solveRunUniqueWithOneEmpty(int run);
+    //Lazily, a run's notes are only filtered if they're quick
+    //to find: memoized, or the run has few empty cells
+    bool filterRunByCombos(int run, bool lazy);
+    //False if they weren't found, and filtering falls back
+    //on the run's combos (or, lazily, isn't done)
+    bool findRunAllowedNotes(int run, quint16 *allowed, bool lazy);
+    bool solveRunNecessaryValues(int run);
+    bool removeRunNakedSubsets(int run);
+    bool solveRunCellsWithOneNote(int run);
+
+    //Searching
+    bool search();
+    bool shouldStop();
+    int pickGuessCell(int &minNotes) const;
+    bool isSolution() const;
+
+    int rows, cols;
+    int numCells, numRuns;
+
+    //Topology, from the model
+    const quint8 *type, *fixed;
+    const int *downRun, *rightRun;
+    const int *runFirst, *runStride;
+    const int *runClue, *runLength;
+
+    //State, from the arena. Bit i of runCombos is set
+    //if combo i of the run's clue in its length is possible.
+    SolverArena arena;
+    quint8 *value;
+    quint16 *mask;
+    quint16 *runCombos;
+    quint8 *runQueued;
+    int *queue;
+    int queueHead, queueSize;
+    TrailEntry *trail;
+    int trailSize, trailCapacity;
+    SearchFrame *frames;
+    int frameCapacity;
+    //Whether the trail or the frames ran out of room. The change
+    //that didn't fit is treated as a contradiction, and the
+    //solve stops with SOLVE_OVERFLOWED
+    bool overflowed;
+
+    //Not part of the arena, since it's kept from one load to
+    //the next, for as long as the Solver is
+    RunMemo runMemo;
+
+    SolveStats stats;
+    QVector<SolveTraceEntry> trace;
+    bool traceEnabled;
+    //stepLogging is whether this solve is still logging, since
+    //logging stops if it gets too big
+    QVector<SolveStep> steps;
+    bool stepLogEnabled, stepLogging;
+
+    //The rule being applied. While hinting, the first place()
+    //is recorded in hint, with the rule that made it
+    SolveRule rule;
+    bool hinting;
+    SolveHint hint;
+
+    SolveStatus status;
+    CancelToken *token;
+    SolveLimits limits;
+    QElapsedTimer solveTimer;
+};
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * solvetask.cpp
+ * See solvetask.h for more information
+ */
+
+#include "solvetask.h"
+#include "puzzleboard.h"
+#include "solutioncache.h"
+#include <QThreadPool>
+#include <QThreadStorage>
+
+//How often progress is checked, in ms
+static const int PROGRESS_INTERVAL = 100;
+
+//One Solver per pool thread, so its run memo
+//lasts from one task to the next
+static QThreadStorage<Solver *> threadSolvers;
+
+SolveTask::SolveTask(TaskType type, const BoardModel &model, bool traceEnabled) {
+    this->type = type;
+    this->model = model;
+    this->traceEnabled = traceEnabled;
+    limits = { 0, 0 };
+    status = SOLVE_UNFINISHED;
+    stats = { 0, 0, 0, 0, 0, 0 };
+    rows = model.rows;
+    cols = model.cols;
+    cellSize = 0;
+    seen = 0;
+
+    setAutoDelete(false);
+    progressTimer = new QTimer(this);
+    lastProgress = 0;
+    connect(progressTimer, SIGNAL(timeout()), this, SLOT(checkProgress()));
+}
+
+SolveTask::SolveTask(int rows, int cols, int cellSize, FingerprintSet *seen) {
+    type = GENERATE_TASK;
+    traceEnabled = false;
+    limits = { 0, 0 };
+    status = SOLVE_UNFINISHED;
+    stats = { 0, 0, 0, 0, 0, 0 };
+    this->rows = rows;
+    this->cols = cols;
+    this->cellSize = cellSize;
+    this->seen = seen;
+
+    setAutoDelete(false);
+    progressTimer = new QTimer(this);
+    lastProgress = 0;
+    connect(progressTimer, SIGNAL(timeout()), this, SLOT(checkProgress()));
+}
+
+void SolveTask::start() {
+    //The timer lives on the GUI thread, so progress() is emitted there
+    connect(this, SIGNAL(finished()), progressTimer, SLOT(stop()));
+    progressTimer->start(PROGRESS_INTERVAL);
+    QThreadPool::globalInstance()->start(this);
+}
+
+void SolveTask::run() {
+    if (type == GENERATE_TASK) {
+        KAKString = PuzzleBoard::generateBoard(rows, cols, cellSize, &token, limits, &status, seen);
+    }
+    else {
+        //A trace or step log only comes from really solving
+        CanonicalForm form(model);
+        bool recording = traceEnabled && type == SOLVE_TASK;
+        if (!recording && SolutionCache::get().lookup(form, model, status)) {
+            emit finished();
+            return;
+        }
+
+        if (!threadSolvers.hasLocalData())
+            threadSolvers.setLocalData(new Solver);
+        Solver &solver = *threadSolvers.localData();
+        solver.setCancelToken(&token);
+        solver.setLimits(limits);
+        solver.setTraceEnabled(traceEnabled && type == SOLVE_TASK);
+        solver.setStepLogEnabled(traceEnabled && type == SOLVE_TASK);
+        solver.load(model);
+        solver.solve();
+        status = solver.getStatus();
+        solver.store(model);
+        stats = solver.getStats();
+        trace = solver.getTrace();
+        steps = solver.getSteps();
+        //The token goes with this task
+        solver.setCancelToken(0);
+        SolutionCache::get().insert(form, model, status);
+    }
+
+    emit finished();
+}
+
+void SolveTask::checkProgress() {
+    int amount = token.getProgress();
+    if (amount != lastProgress) {
+        lastProgress = amount;
+        emit progress(amount);
+    }
+}
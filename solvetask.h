@@ -0,0 +1,87 @@
+/*
+ * solvetask.h
+ *
+ * A SolveTask solves, checks or generates a board on a
+ * QThreadPool thread, so the window keeps drawing (and the timer
+ * keeps ticking) while it works. It works on its own copy of
+ * the board, and only hands back results when it's finished.
+ *
+ * It can be cancelled from the GUI thread at any time, and can be
+ * given a time limit or a budget of guesses. While it runs,
+ * progress() is emitted on the GUI thread with the number of
+ * guesses made (solving) or clue assignments tried (generating).
+ * finished() is emitted once, whether or not it was cancelled.
+ *
+ * The task doesn't delete itself; whoever started it should
+ * deleteLater() it after finished().
+ */
+
+#ifndef SOLVETASK_H
+#define SOLVETASK_H
+
+#include <QObject>
+#include <QRunnable>
+#include <QTimer>
+#include "solver.h"
+#include "boardmodel.h"
+#include "fingerprint.h"
+
+class SolveTask : public QObject, public QRunnable {
+    Q_OBJECT
+
+public:
+    enum TaskType { SOLVE_TASK = 0, CHECK_TASK, GENERATE_TASK };
+
+    //Solving or checking a copy of a board
+    SolveTask(TaskType type, const BoardModel &model, bool traceEnabled);
+    //Generating a new board, that isn't in seen (if given)
+    SolveTask(int rows, int cols, int cellSize, FingerprintSet *seen = 0);
+
+    //Starts the task on the global thread pool
+    void start();
+    void cancel() { token.cancel(); }
+    //Call before start()
+    void setLimits(const SolveLimits &l) { limits = l; }
+
+    void run() Q_DECL_OVERRIDE;
+
+    //Results, valid after finished()
+    TaskType getType() const { return type; }
+    bool getCancelled() const { return token.isCancelled(); }
+    bool getSolved() const { return status == SOLVE_SOLVED; }
+    SolveStatus getStatus() const { return status; }
+    const BoardModel &getModel() const { return model; }
+    SolveStats getStats() const { return stats; }
+    const QVector<SolveTraceEntry> &getTrace() const { return trace; }
+    const QVector<SolveStep> &getSteps() const { return steps; }
+    QString getKAKString() const { return KAKString; }
+
+signals:
+    void progress(int amount);
+    void finished();
+
+private slots:
+    void checkProgress();
+
+private:
+    TaskType type;
+    CancelToken token;
+    SolveLimits limits;
+    SolveStatus status;
+    QTimer *progressTimer;
+    int lastProgress;
+
+    //Solving and checking
+    BoardModel model;
+    bool traceEnabled;
+    SolveStats stats;
+    QVector<SolveTraceEntry> trace;
+    QVector<SolveStep> steps;
+
+    //Generating
+    int rows, cols, cellSize;
+    FingerprintSet *seen;
+    QString KAKString;
+};
+
+#endif
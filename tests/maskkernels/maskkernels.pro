@@ -0,0 +1,15 @@
+QT       += core testlib
+QT       -= gui
+
+TARGET = tst_maskkernels
+CONFIG += console testcase c++11
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_maskkernels.cpp \
+    ../../maskkernels.cpp
+
+HEADERS += ../../maskkernels.h
@@ -0,0 +1,110 @@
+/*
+ * tst_maskkernels.cpp
+ *
+ * Checks that every set of MaskKernels the CPU can run gives the
+ * same masks as the scalar ones, on random runs, for lane counts
+ * around the SIMD widths (so the scalar tails are covered too).
+ * "make check" in the kakuro build builds and runs it.
+ */
+
+#include <QtTest>
+#include <cstdlib>
+#include "maskkernels.h"
+
+static const quint16 ALL_NOTES = 0x3FE;
+static const int NUM_CELLS = 40;
+static const int ROUNDS = 2000;
+
+//Mostly a few notes, sometimes solved or empty
+static quint16 randomMask() {
+    switch (std::rand() % 8) {
+    case 0:
+        return 0;
+    case 1:
+    case 2:
+        return quint16(1 << (1 + std::rand() % 9));
+    default:
+        return quint16(std::rand() & ALL_NOTES);
+    }
+}
+
+class TestMaskKernels : public QObject {
+    Q_OBJECT
+
+private slots:
+    void sameAsScalar_data();
+    void sameAsScalar();
+    void pickedByLanes();
+};
+
+void TestMaskKernels::sameAsScalar_data() {
+    QTest::addColumn<int>("kernels");
+    QTest::addColumn<int>("lanes");
+
+    const QVector<const MaskKernels *> &available = MaskKernels::getAvailable();
+    const int laneCounts[] = { 1, 7, 8, 9, 15, 16, 17, 24, 33 };
+    for (int n = 1; n < available.size(); n++) {
+        for (int lanes : laneCounts) {
+            QTest::newRow(qPrintable(QString("%1, %2 lanes").arg(available[n]->name).arg(lanes)))
+                    << n << lanes;
+        }
+    }
+}
+
+void TestMaskKernels::sameAsScalar() {
+    QFETCH(int, kernels);
+    QFETCH(int, lanes);
+    const MaskKernels &simd = *MaskKernels::getAvailable()[kernels];
+    const MaskKernels &scalar = MaskKernels::scalar();
+
+    std::srand(uint(kernels*100 + lanes));
+    QVector<quint16> masks(NUM_CELLS*lanes), expected, perLane(lanes);
+    QVector<qint16> clues(lanes);
+    for (int round = 0; round < ROUNDS; round++) {
+        int length = 2 + std::rand() % 8;
+        int stride = 1 + std::rand() % 4;
+        int first = std::rand() % (NUM_CELLS - (length - 1)*stride);
+        for (int i = 0; i < masks.size(); i++) {
+            masks[i] = randomMask();
+        }
+        for (int l = 0; l < lanes; l++) {
+            perLane[l] = quint16(std::rand() & ALL_NOTES);
+            clues[l] = qint16(3 + std::rand() % 43);
+        }
+
+        int rule = round % 3;
+        expected = masks;
+        bool changed, expectedChanged;
+        if (rule == 0) {
+            changed = simd.filterByCombos(masks.data(), lanes, first, stride, length, perLane.data());
+            expectedChanged = scalar.filterByCombos(expected.data(), lanes, first, stride, length, perLane.data());
+        }
+        else if (rule == 1) {
+            changed = simd.forceDigits(masks.data(), lanes, first, stride, length, perLane.data());
+            expectedChanged = scalar.forceDigits(expected.data(), lanes, first, stride, length, perLane.data());
+        }
+        else {
+            changed = simd.adjustByRange(masks.data(), lanes, first, stride, length, clues.data());
+            expectedChanged = scalar.adjustByRange(expected.data(), lanes, first, stride, length, clues.data());
+        }
+
+        if (masks != expected || changed != expectedChanged)
+            QFAIL(qPrintable(QString("rule %1 differs in round %2").arg(rule).arg(round)));
+    }
+}
+
+void TestMaskKernels::pickedByLanes() {
+    //Never wider than the lanes, unless nothing is that narrow
+    const QVector<const MaskKernels *> &available = MaskKernels::getAvailable();
+    for (int lanes = 1; lanes <= 40; lanes++) {
+        const MaskKernels &picked = MaskKernels::get(lanes);
+        QVERIFY(picked.width <= lanes || picked.width == 1);
+        for (int n = 0; n < available.size(); n++) {
+            QVERIFY(available[n]->width > lanes || available[n]->width <= picked.width);
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(TestMaskKernels)
+
+#include "tst_maskkernels.moc"
@@ -0,0 +1,20 @@
+QT       += core testlib
+QT       -= gui
+
+TARGET = tst_solveralloc
+CONFIG += console testcase c++11
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_solveralloc.cpp \
+    ../../solver.cpp \
+    ../../runmemo.cpp \
+    ../../boardmodel.cpp
+
+HEADERS += ../../solver.h \
+    ../../runmemo.h \
+    ../../boardmodel.h \
+    ../../common.h
@@ -0,0 +1,170 @@
+/*
+ * tst_solveralloc.cpp
+ *
+ * Checks that the Solver doesn't touch the heap once a board is
+ * loaded: every operator new is counted, and solving (logic and
+ * brute force, solvable or not) must not add to the count.
+ * The trace and step log are off, since they're allowed to grow.
+ * "make check" in the kakuro build builds and runs it.
+ */
+
+#include <QtTest>
+#include <QStringList>
+#include <cstdlib>
+#include <new>
+#include "solver.h"
+#include "boardmodel.h"
+
+static QAtomicInt allocations;
+
+void *operator new(std::size_t size) {
+    allocations.ref();
+    void *p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+//Builds a model from the cells of a KAKString, without the size,
+//cell size and time: "-" is a blank clue, "d/r" a clue, and a
+//number a nonclue (fixed if it ends in 'f')
+static BoardModel makeModel(int rows, int cols, const QString &cells) {
+    QVector<CellInfo> info;
+    foreach (const QString &token, cells.split(' ', QString::SkipEmptyParts)) {
+        CellInfo cell;
+        cell.valueOrClues[0] = cell.valueOrClues[1] = 0;
+        for (int i = 0; i < 10; i++) {
+            cell.notes[i] = false;
+        }
+        cell.fixed = false;
+
+        if (token == "-") {
+            cell.type = CLUE;
+        }
+        else if (token.contains('/')) {
+            cell.type = CLUE;
+            cell.valueOrClues[0] = token.section('/', 0, 0).toInt();
+            cell.valueOrClues[1] = token.section('/', 1, 1).toInt();
+        }
+        else {
+            cell.type = NONCLUE;
+            cell.fixed = token.endsWith('f');
+            cell.valueOrClues[0] = QString(token).remove('f').toInt();
+        }
+        info.push_back(cell);
+    }
+
+    BoardModel model;
+    model.load(rows, cols, info);
+    return model;
+}
+
+//The default board of the game
+static const char *DEFAULT_BOARD =
+        "- 7/0 34/0 - 28/0 23/0 41/0 - 32/0 10/0 "
+        "0/7 0 0 0/15 0 0 0 0/3 0 0 "
+        "0/14 0 0 41/23 0 0 0 28/15 0 0 "
+        "- 7/28 0 0 0 0 0 0 0 11/0 "
+        "0/29 0 0 0 0 0/14 0 0 0 0 "
+        "0/18 0 0 0 0 3/29 0 0 0 0 "
+        "- - 14/16 0 0 0 0 0 16/0 - "
+        "- 8/41 0 0 0 0 0 0 0 4/0 "
+        "0/9 0 0 0 - - 0/7 0 0 0 "
+        "0/22 0 0 0 - - 0/17 0 0 0";
+
+class TestSolverAlloc : public QObject {
+    Q_OBJECT
+
+private slots:
+    void solveWithoutAllocating_data();
+    void solveWithoutAllocating();
+    void reloadWithoutAllocating();
+};
+
+void TestSolverAlloc::solveWithoutAllocating_data() {
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("cols");
+    QTest::addColumn<QString>("cells");
+    QTest::addColumn<int>("status");
+    QTest::addColumn<bool>("guesses");
+
+    QTest::newRow("default board") << 10 << 10 << QString(DEFAULT_BOARD)
+                                   << int(SOLVE_SOLVED) << false;
+    //Every 3x3 latin square of 1-3 fits, so logic gets nowhere
+    QTest::newRow("latin square") << 4 << 4
+                                  << QString("- 6/0 6/0 6/0 "
+                                             "0/6 0 0 0 "
+                                             "0/6 0 0 0 "
+                                             "0/6 0 0 0")
+                                  << int(SOLVE_SOLVED) << true;
+    //The same, with a fixed cell that rules out the
+    //first guesses
+    QTest::newRow("latin square, fixed") << 4 << 4
+                                         << QString("- 6/0 6/0 6/0 "
+                                                    "0/6 0 0 0 "
+                                                    "0/6 0 0 0 "
+                                                    "0/6 0 0 3f")
+                                         << int(SOLVE_SOLVED) << true;
+    //7 in two cells down, but 9 in the same two across
+    QTest::newRow("unsolvable") << 3 << 3
+                                << QString("- 7/0 10/0 "
+                                           "0/9 0 0 "
+                                           "0/9 0 0")
+                                << int(SOLVE_UNSOLVABLE) << false;
+}
+
+void TestSolverAlloc::solveWithoutAllocating() {
+    QFETCH(int, rows);
+    QFETCH(int, cols);
+    QFETCH(QString, cells);
+    QFETCH(int, status);
+    QFETCH(bool, guesses);
+
+    BoardModel model = makeModel(rows, cols, cells);
+    Solver solver;
+    solver.load(model);
+
+    int before = allocations.load();
+    solver.solve();
+    int after = allocations.load();
+
+    QCOMPARE(after - before, 0);
+    QCOMPARE(int(solver.getStatus()), status);
+    QCOMPARE(solver.getStats().nodes > 0, guesses);
+}
+
+void TestSolverAlloc::reloadWithoutAllocating() {
+    //The arena is kept, so a board no bigger than the
+    //last one doesn't allocate while loading either
+    BoardModel big = makeModel(10, 10, DEFAULT_BOARD);
+    BoardModel small = makeModel(4, 4, "- 6/0 6/0 6/0 0/6 0 0 0 0/6 0 0 0 0/6 0 0 0");
+    Solver solver;
+    solver.load(big);
+    solver.solve();
+
+    int before = allocations.load();
+    solver.load(small);
+    solver.solve();
+    solver.load(big);
+    solver.solve();
+    int after = allocations.load();
+
+    QCOMPARE(after - before, 0);
+    QCOMPARE(solver.getStatus(), SOLVE_SOLVED);
+}
+
+QTEST_APPLESS_MAIN(TestSolverAlloc)
+
+#include "tst_solveralloc.moc"